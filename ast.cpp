@@ -0,0 +1,105 @@
+#include "ast.hpp"
+
+namespace holeyc{
+
+void * ASTNode::operator new(size_t size){
+	MemStats::allocated(MemStats::AST, size);
+	return ::operator new(size);
+}
+
+//Nodes are deleted through a virtual destructor, so size is
+// the size of the most derived class
+void ASTNode::operator delete(void * ptr, size_t size){
+	MemStats::freed(MemStats::AST, size);
+	::operator delete(ptr);
+}
+
+RefNode::~RefNode(){
+	delete myID;
+}
+
+DerefNode::~DerefNode(){
+	delete myID;
+}
+
+IndexNode::~IndexNode(){
+	delete myBase;
+	delete myOffset;
+}
+
+VarDeclNode::~VarDeclNode(){
+	delete myType;
+	delete myID;
+}
+
+FnDeclNode::~FnDeclNode(){
+	delete myID;
+	delete myRetType;
+	deleteNodes(myFormals);
+	deleteNodes(myBody);
+}
+
+AssignStmtNode::~AssignStmtNode(){
+	delete myExp;
+}
+
+FromConsoleStmtNode::~FromConsoleStmtNode(){
+	delete myDst;
+}
+
+ToConsoleStmtNode::~ToConsoleStmtNode(){
+	delete mySrc;
+}
+
+PostDecStmtNode::~PostDecStmtNode(){
+	delete myLVal;
+}
+
+PostIncStmtNode::~PostIncStmtNode(){
+	delete myLVal;
+}
+
+IfStmtNode::~IfStmtNode(){
+	delete myCond;
+	deleteNodes(myBody);
+}
+
+IfElseStmtNode::~IfElseStmtNode(){
+	delete myCond;
+	deleteNodes(myBodyTrue);
+	deleteNodes(myBodyFalse);
+}
+
+WhileStmtNode::~WhileStmtNode(){
+	delete myCond;
+	deleteNodes(myBody);
+}
+
+ReturnStmtNode::~ReturnStmtNode(){
+	delete myExp;
+}
+
+CallExpNode::~CallExpNode(){
+	delete myID;
+	deleteNodes(myArgs);
+}
+
+BinaryExpNode::~BinaryExpNode(){
+	delete myExp1;
+	delete myExp2;
+}
+
+UnaryExpNode::~UnaryExpNode(){
+	delete myExp;
+}
+
+AssignExpNode::~AssignExpNode(){
+	delete myDst;
+	delete mySrc;
+}
+
+CallStmtNode::~CallStmtNode(){
+	delete myCallExp;
+}
+
+}
@@ -5,7 +5,9 @@
 #include <sstream>
 #include <string.h>
 #include <list>
+#include <unordered_set>
 #include "err.hpp"
+#include "mem_stats.hpp"
 #include "tokens.hpp"
 #include "types.hpp"
 #include "symbol_table.hpp"
@@ -13,6 +15,9 @@
 namespace holeyc {
 
 class TypeAnalysis;
+class Runtime;
+class ASTWriter;
+enum ASTTag : unsigned char;
 
 // class Opd;
 
@@ -36,11 +41,25 @@ class LValNode;
 class IDNode;
 class CallExpNode;
 
+//Delete each node in a list of children, then the list itself
+template <typename T>
+void deleteNodes(std::list<T *> * nodes){
+	for (T * node : *nodes){ delete node; }
+	delete nodes;
+}
+
 class ASTNode{
 public:
 	ASTNode(size_t lineIn, size_t colIn)
 	: l(lineIn), c(colIn){ }
+	//A node owns its children and deletes them with itself
+	virtual ~ASTNode(){ }
+	//Nodes are allocated through these so that they are counted
+	// in MemStats
+	static void * operator new(size_t size);
+	static void operator delete(void * ptr, size_t size);
 	virtual void unparse(std::ostream&, int) = 0;
+	virtual void serialize(ASTWriter&) = 0;
 	size_t line() const { return this->l; }
 	size_t col() const { return this->c; }
 	std::string pos(){
@@ -63,6 +82,9 @@ public:
   virtual void unparse(std::ostream &out, int indent) override = 0;
   virtual std::string nodeKind() override = 0;
   virtual void typeAnalysis(TypeAnalysis *) = 0;
+  //Run a statement that has passed type analysis
+  virtual void execute(Runtime *) = 0;
+  virtual bool isDecl() { return false; }
   virtual bool isFnDecl() { return false; }
   virtual bool isCallStmt() { return false; }
   virtual CallExpNode *getCallExp() { return nullptr; }
@@ -75,6 +97,7 @@ public:
 	: ASTNode(1,1), myGlobals(globalsIn){}
 	virtual std::string nodeKind() override { return "Program"; }
 	void unparse(std::ostream&, int) override;
+	void serialize(ASTWriter& out) override;
   std::list<StmtNode *> * getGlobals() { return myGlobals; }
   void addGlobal(StmtNode * stmt) {
     if(myGlobals->size() == 0){
@@ -84,7 +107,7 @@ public:
   }
   virtual bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *);
-	virtual ~ProgramNode(){ }
+	virtual ~ProgramNode(){ deleteNodes(myGlobals); }
 private:
 	std::list<StmtNode *> * myGlobals;
 };
@@ -96,14 +119,13 @@ public:
 	virtual void unparse(std::ostream& out, int indent) override = 0;
 	virtual bool nameAnalysis(SymbolTable * symTab) override = 0;
 	virtual void typeAnalysis(TypeAnalysis *) = 0;
-  virtual int * getIntValue() { return nullptr; }
-  virtual bool * getBoolValue() { return nullptr; }
-  virtual char * getCharValue() { return nullptr; }
-  virtual string * getStrValue() { 
-    string * bs = new string;
-    *bs = "if you see this refer to ExpNode in ast.hpp. Problem\n";
-    return bs; 
-  }
+	//The value of an expression that has passed type analysis.
+	// Only the getter matching the expression's type is called.
+	// A pointer is an address in the runtime's memory.
+	virtual int getIntValue(Runtime *) { return 0; }
+	virtual bool getBoolValue(Runtime *) { return false; }
+	virtual char getCharValue(Runtime *) { return 0; }
+	virtual size_t getPtrValue(Runtime *) { return 0; }
 };
 
 class LValNode : public ExpNode{
@@ -115,10 +137,13 @@ public:
 	void attachSymbol(SemSymbol * symbolIn) { } 
 	bool nameAnalysis(SymbolTable * symTab) override { return false; }
 	virtual void typeAnalysis(TypeAnalysis *) override {; } 
-  virtual void addValueToSymbol(int *valInt, bool *valBool, char *valChar) = 0;
-  virtual int * getIntValue() override { return nullptr; }
-  virtual bool * getBoolValue() override { return nullptr; }
-  virtual char * getCharValue() override { return nullptr; }
+	//Where the value lives in the runtime's memory. The value
+	// getters load from there.
+	virtual size_t getAddress(Runtime *) = 0;
+	int getIntValue(Runtime * runtime) override;
+	bool getBoolValue(Runtime * runtime) override;
+	char getCharValue(Runtime * runtime) override;
+	size_t getPtrValue(Runtime * runtime) override;
 };
 
 class IDNode : public LValNode{
@@ -128,32 +153,12 @@ public:
 	std::string getName(){ return name; }
 	virtual std::string nodeKind() override { return "ID"; }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	void attachSymbol(SemSymbol * symbolIn);
 	SemSymbol * getSymbol() const { return mySymbol; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual void addValueToSymbol(int *valInt, bool *valBool, char *valChar) override;
-  virtual int *getIntValue() override {
-    if(mySymbol){
-      return mySymbol->getIntVal();
-    } else {
-      return nullptr;
-    }
-  }
-  virtual bool * getBoolValue() override {
-    if(mySymbol){
-      return mySymbol->getBoolVal();
-    } else {
-      return nullptr;
-    }
-  }
-  virtual char *getCharValue() override {
-    if(mySymbol){
-      return mySymbol->getCharVal();
-    } else {
-      return nullptr;
-    }
-  }
+	virtual size_t getAddress(Runtime * runtime) override;
 
 private:
 	std::string name;
@@ -164,16 +169,18 @@ class RefNode : public LValNode{
 public:
 	RefNode(size_t l, size_t c, IDNode * id)
 	: LValNode(l, c), myID(id){ }
+	~RefNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "Ref"; }
 
 	virtual bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	// virtual Opd * flatten(Procedure * prog) override;
-  virtual void addValueToSymbol(int *valInt, bool *valBool, char *valChar) override { return; } 
-  // virtual int *getIntValue() override { return nullptr; }
-  // virtual bool *getBoolValue() override { return nullptr; }
-  // virtual char *getCharValue() override { return nullptr; }
+	//A reference is a value, not a place: it has no address of
+	// its own to store to
+	virtual size_t getAddress(Runtime *) override { return 0; }
+	virtual size_t getPtrValue(Runtime * runtime) override;
 
 private:
 	IDNode * myID;
@@ -183,15 +190,14 @@ class DerefNode : public LValNode{
 public:
 	DerefNode(size_t l, size_t c, IDNode * id)
 	: LValNode(l, c), myID(id){ }
+	~DerefNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "Deref"; }
 	virtual bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	// virtual Opd * flatten(Procedure * prog) override;
-  virtual void addValueToSymbol(int *valInt, bool *valBool, char *valChar) override { return; }
-  // virtual int *getIntValue() override { return nullptr; }
-  // virtual bool *getBoolValue() override { return nullptr; }
-  // virtual char *getCharValue() override { return nullptr; }
+	virtual size_t getAddress(Runtime * runtime) override;
 
 private:
 	IDNode * myID;
@@ -200,22 +206,23 @@ private:
 class IndexNode : public LValNode{
 public:
 	IndexNode(size_t l, size_t c, IDNode * id, ExpNode * offset)
-	: LValNode(l, c), myBase(id), myOffset(offset){ }
+	: LValNode(l, c), myBase(id), myOffset(offset), myElemSize(0){ }
+	~IndexNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "Index"; }
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 	// virtual Opd * flatten(Procedure * prog) override{
 		// throw new ToDoError("Implement");
 	// }
-  virtual void addValueToSymbol(int *valInt, bool *valBool, char *valChar) override { return; }
-  // virtual int *getIntValue() override { return nullptr; }
-  // virtual bool *getBoolValue() override { return nullptr; }
-  // virtual char *getCharValue() override { return nullptr; }
+	virtual size_t getAddress(Runtime * runtime) override;
 
 private:
 	IDNode * myBase;
 	ExpNode * myOffset;
+	//Set by type analysis: the size of what the base points to
+	size_t myElemSize;
 };
 
 
@@ -234,6 +241,7 @@ public:
 	CharTypeNode(size_t lIn, size_t cIn, bool isPtrIn)
 	: TypeNode(lIn, cIn), isPtr(isPtrIn){}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { 
 		return "char";
 	}
@@ -258,6 +266,7 @@ private:
 class DeclNode : public StmtNode{
 public:
 	DeclNode(size_t l, size_t c) : StmtNode(l, c){ }
+	virtual bool isDecl() override { return true; }
 	void unparse(std::ostream& out, int indent) override =0;
 	virtual std::string nodeKind() override = 0;
 	virtual void typeAnalysis(TypeAnalysis *) override = 0; 
@@ -267,12 +276,15 @@ class VarDeclNode : public DeclNode{
 public:
 	VarDeclNode(size_t lIn, size_t cIn, TypeNode * typeIn, IDNode * IDIn)
 	: DeclNode(lIn, cIn), myType(typeIn), myID(IDIn){ }
+	~VarDeclNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "VarDecl"; }
 	IDNode * ID(){ return myID; }
 	TypeNode * getTypeNode(){ return myType; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis * typing) override;
+	virtual void execute(Runtime *) override;
 private:
 	TypeNode * myType;
 	IDNode * myID;
@@ -283,6 +295,7 @@ public:
 	FormalDeclNode(size_t lIn, size_t cIn, TypeNode * type, IDNode * id) 
 	: VarDeclNode(lIn, cIn, type, id){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "FormalDecl"; }
 };
 
@@ -294,15 +307,32 @@ public:
 	  std::list<StmtNode *> * bodyIn)
 	: DeclNode(lIn, cIn), 
 	  myID(idIn), myRetType(retTypeIn),
-	  myFormals(formalsIn), myBody(bodyIn){ }
+	  myFormals(formalsIn), myBody(bodyIn), myFrameSize(0){ }
+	~FnDeclNode();
 	IDNode * ID() const { return myID; }
 	std::list<FormalDeclNode *> * getFormals() const{
 		return myFormals;
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "FnDecl"; }
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
-	virtual void typeAnalysis(TypeAnalysis *) override;
+	//Name analysis for a definition that replaces an earlier
+	// function of the same name. The earlier function's symbol is
+	// reused, so calls already bound to it reach the new body.
+	bool redefine(SymbolTable * symTab, SemSymbol * oldSym);
+	virtual void typeAnalysis(TypeAnalysis *) override;
+	//Declaring a function runs nothing; call runs its body in a
+	// frame the runtime has already set up
+	virtual void execute(Runtime *) override;
+	void call(Runtime * runtime);
+	//The bytes each call needs for the formals and locals
+	size_t frameSize() const { return myFrameSize; }
+	//The symbols from enclosing scopes that the function refers
+	// to, as found by name analysis
+	const std::unordered_set<SemSymbol *>& getUses() const {
+		return myUses;
+	}
 	virtual TypeNode * getRetTypeNode() { 
 		return myRetType;
 	}
@@ -319,16 +349,22 @@ private:
 	TypeNode * myRetType;
 	std::list<FormalDeclNode *> * myFormals;
 	std::list<StmtNode *> * myBody;
+	std::unordered_set<SemSymbol *> myUses;
+	size_t myFrameSize;
+	bool analyze(SymbolTable * symTab, SemSymbol * oldSym);
 };
 
 class AssignStmtNode : public StmtNode{
 public:
 	AssignStmtNode(size_t l, size_t c, AssignExpNode * expIn)
 	: StmtNode(l, c), myExp(expIn){ }
+	~AssignStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "AssignStmt"; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	virtual void execute(Runtime *) override;
 private:
 	AssignExpNode * myExp;
 };
@@ -336,41 +372,48 @@ private:
 class FromConsoleStmtNode : public StmtNode{
 public:
 	FromConsoleStmtNode(size_t l, size_t c, LValNode * dstIn)
-	: StmtNode(l, c), myDst(dstIn){ }
+	: StmtNode(l, c), myDst(dstIn), myDstType(nullptr){ }
+	~FromConsoleStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "FromConsoleStmt"; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	virtual void execute(Runtime *) override;
 private:
 	LValNode * myDst;
+	//Set by type analysis; decides what is read
+	const BasicType * myDstType;
 };
 
 class ToConsoleStmtNode : public StmtNode{
 public:
 	ToConsoleStmtNode(size_t l, size_t c, ExpNode * srcIn)
-	: StmtNode(l, c), mySrc(srcIn){ }
+	: StmtNode(l, c), mySrc(srcIn), mySrcType(nullptr){ }
+	~ToConsoleStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "ToConsoleStmt"; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	virtual void execute(Runtime *) override;
 private:
 	ExpNode * mySrc;
+	//Set by type analysis; decides how the value is written
+	const DataType * mySrcType;
 };
 
 class PostDecStmtNode : public StmtNode{
 public:
 	PostDecStmtNode(size_t l, size_t c, LValNode * lvalIn)
 	: StmtNode(l, c), myLVal(lvalIn){ }
+	~PostDecStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "PostDecStmt"; }
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual int *getIntValue() {
-    int *val = new int;
-    int *val2 = myLVal->getIntValue();
-    *val = *val2 - 1;
-    return val;
-  }
+	virtual void execute(Runtime *) override;
 private:
 	LValNode * myLVal;
 };
@@ -379,29 +422,29 @@ class PostIncStmtNode : public StmtNode{
 public:
 	PostIncStmtNode(size_t l, size_t c, LValNode * lvalIn)
 	: StmtNode(l, c), myLVal(lvalIn){ }
+	~PostIncStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "PostIncStmt"; }
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual int *getIntValue() {
-    int *val = new int;
-    int *val2 = myLVal->getIntValue();
-    *val = *val2 + 1;
-    return val;
-  }
-  private:
-    LValNode *myLVal;
-  };
+	virtual void execute(Runtime *) override;
+private:
+	LValNode * myLVal;
+};
 
 class IfStmtNode : public StmtNode{
 public:
 	IfStmtNode(size_t l, size_t c, ExpNode * condIn,
 	  std::list<StmtNode *> * bodyIn)
 	: StmtNode(l, c), myCond(condIn), myBody(bodyIn){ }
+	~IfStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "IfStmt"; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	virtual void execute(Runtime *) override;
 private:
 	ExpNode * myCond;
 	std::list<StmtNode *> * myBody;
@@ -414,10 +457,13 @@ public:
 	  std::list<StmtNode *> * bodyFalseIn)
 	: StmtNode(l, c), myCond(condIn),
 	  myBodyTrue(bodyTrueIn), myBodyFalse(bodyFalseIn) { }
+	~IfElseStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "IfElseStmt"; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	virtual void execute(Runtime *) override;
 private:
 	ExpNode * myCond;
 	std::list<StmtNode *> * myBodyTrue;
@@ -429,10 +475,13 @@ public:
 	WhileStmtNode(size_t l, size_t c, ExpNode * condIn, 
 	  std::list<StmtNode *> * bodyIn)
 	: StmtNode(l, c), myCond(condIn), myBody(bodyIn){ }
+	~WhileStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "WhileStmt"; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	virtual void execute(Runtime *) override;
 private:
 	ExpNode * myCond;
 	std::list<StmtNode *> * myBody;
@@ -441,13 +490,18 @@ private:
 class ReturnStmtNode : public StmtNode{
 public:
 	ReturnStmtNode(size_t l, size_t c, ExpNode * exp)
-	: StmtNode(l, c), myExp(exp){ }
+	: StmtNode(l, c), myExp(exp), myType(nullptr){ }
+	~ReturnStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "ReturnStmt"; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	virtual void execute(Runtime *) override;
 private:
 	ExpNode * myExp;
+	//Set by type analysis: the type of the returned value
+	const DataType * myType;
 };
 
 class CallExpNode : public ExpNode{
@@ -455,21 +509,21 @@ public:
 	CallExpNode(size_t l, size_t c, IDNode * id,
 	  std::list<ExpNode *> * argsIn)
 	: ExpNode(l, c), myID(id), myArgs(argsIn){ }
+	~CallExpNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "CallExp"; }
   IDNode * getID() { return myID; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis *) override;
 	DataType * getRetType();
-  // int * getIntValue() override {
-
-  // }
-  // bool * getBoolValue() override {
-
-  // }
-  // char * getCharValue() override {
-
-  // }
+	//Run the callee with these arguments. What it returns is
+	// left in the runtime's return slot for the getters.
+	void call(Runtime * runtime);
+	int getIntValue(Runtime * runtime) override;
+	bool getBoolValue(Runtime * runtime) override;
+	char getCharValue(Runtime * runtime) override;
+	size_t getPtrValue(Runtime * runtime) override;
 private:
 	IDNode * myID;
 	std::list<ExpNode *> * myArgs;
@@ -479,6 +533,7 @@ class BinaryExpNode : public ExpNode{
 public:
 	BinaryExpNode(size_t lIn, size_t cIn, ExpNode * lhs, ExpNode * rhs)
 	: ExpNode(lIn, cIn), myExp1(lhs), myExp2(rhs), expTypes("") { }
+	~BinaryExpNode();
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override = 0;
   bool matchesExpTypes(string type) { return expTypes == type; }
@@ -490,6 +545,7 @@ protected:
 	void binaryEqTyping(TypeAnalysis * typing);
 	void binaryRelTyping(TypeAnalysis * typing);
 	void binaryMathTyping(TypeAnalysis * typing);
+	void serializeBinary(ASTWriter& out, ASTTag tag);
   virtual void setExpTypes(const DataType * type){
     if(type->isInt()){
       expTypes = "int";
@@ -497,7 +553,8 @@ protected:
       expTypes = "char";
     } else if (type->isBool()){
       expTypes = "bool";
-    } else {
+    } else if (type->isPtr()){
+      expTypes = "ptr";
     }
   }
 };
@@ -507,16 +564,10 @@ public:
 	PlusNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "Plus"; }
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	
-  virtual int *getIntValue() override{
-    int *val = new int;
-    int *val1 = myExp1->getIntValue();
-    int *val2 = myExp2->getIntValue();
-    *val = *val1 + *val2;
-    return val;
-  }
+	int getIntValue(Runtime * runtime) override;
 };
 
 class MinusNode : public BinaryExpNode{
@@ -524,16 +575,10 @@ public:
 	MinusNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "Minus"; }
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	
-  virtual int *getIntValue() override{
-    int *val = new int;
-    int *val1 = myExp1->getIntValue();
-    int *val2 = myExp2->getIntValue();
-    *val = *val1 - *val2;
-    return val;
-  }
+	int getIntValue(Runtime * runtime) override;
 };
 
 class TimesNode : public BinaryExpNode{
@@ -541,16 +586,10 @@ public:
 	TimesNode(size_t l, size_t c, ExpNode * e1In, ExpNode * e2In)
 	: BinaryExpNode(l, c, e1In, e2In){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "Times"; }
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	
-  virtual int *getIntValue() override{
-    int *val = new int;
-    int *val1 = myExp1->getIntValue();
-    int *val2 = myExp2->getIntValue();
-    *val = (*val1) * (*val2);
-    return val;
-  }
+	int getIntValue(Runtime * runtime) override;
 };
 
 class DivideNode : public BinaryExpNode{
@@ -558,16 +597,10 @@ public:
 	DivideNode(size_t lIn, size_t cIn, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(lIn, cIn, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "Divide"; }
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	
-  virtual int *getIntValue() override{
-    int *val = new int;
-    int *val1 = myExp1->getIntValue();
-    int *val2 = myExp2->getIntValue();
-    *val = *val1 / *val2;
-    return val;
-  }
+	int getIntValue(Runtime * runtime) override;
 };
 
 class AndNode : public BinaryExpNode{
@@ -575,20 +608,10 @@ public:
 	AndNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "And"; }
 	virtual void typeAnalysis(TypeAnalysis *) override;
-	
-  virtual char *getCharValue() override { return nullptr; }
-  virtual int *getIntValue() override{
-    return nullptr;
-  }
-  virtual bool *getBoolValue() override { 
-    bool * val = new bool;
-    bool * val1 = myExp1->getBoolValue();
-    bool * val2 = myExp2->getBoolValue();
-    *val = *val1 && *val2; 
-    return val;
-  }
+	bool getBoolValue(Runtime * runtime) override;
 };
 
 class OrNode : public BinaryExpNode{
@@ -596,15 +619,10 @@ public:
 	OrNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "Or"; }
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual bool *getBoolValue() override { 
-    bool * val = new bool;
-    bool * val1 = myExp1->getBoolValue();
-    bool * val2 = myExp2->getBoolValue();
-    *val = *val1 || *val2; 
-    return val;
-  }
+	bool getBoolValue(Runtime * runtime) override;
 };
 
 class EqualsNode : public BinaryExpNode{
@@ -612,26 +630,10 @@ public:
 	EqualsNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "Eq"; }
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual bool *getBoolValue() override {
-    bool * val = new bool;
-    if(matchesExpTypes("bool")){
-      bool * val1 = myExp1->getBoolValue();
-      bool *val2 = myExp2->getBoolValue();
-      *val = *val1 == *val2;
-    } else if (matchesExpTypes("int")){
-      int *ival1 = myExp1->getIntValue();
-      int *ival2 = myExp2->getIntValue();
-      *val = *ival1 == *ival2;
-    } else if (matchesExpTypes("char")){
-      char *cval1 = myExp1->getCharValue();
-      char *cval2 = myExp2->getCharValue();
-      *val = *cval1 == *cval2;
-    } else {
-    }
-    return val;
-  }
+	bool getBoolValue(Runtime * runtime) override;
 };
 
 class NotEqualsNode : public BinaryExpNode{
@@ -639,26 +641,10 @@ public:
 	NotEqualsNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "NotEq"; }
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual bool *getBoolValue() override { 
-    bool * val = new bool;
-    if(matchesExpTypes("bool")){
-      bool * val1 = myExp1->getBoolValue();
-      bool *val2 = myExp2->getBoolValue();
-      *val = *val1 != *val2;
-    } else if (matchesExpTypes("int")){
-      int *ival1 = myExp1->getIntValue();
-      int *ival2 = myExp2->getIntValue();
-      *val = *ival1 != *ival2;
-    } else if (matchesExpTypes("char")){
-      char *cval1 = myExp1->getCharValue();
-      char *cval2 = myExp2->getCharValue();
-      *val = *cval1 != *cval2;
-    } else {
-    }
-    return val;
-  }
+	bool getBoolValue(Runtime * runtime) override;
 };
 
 class LessNode : public BinaryExpNode{
@@ -667,26 +653,10 @@ public:
 		ExpNode * exp1, ExpNode * exp2)
 	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "Less"; }
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual bool *getBoolValue() override {
-    bool * val = new bool;
-    if(matchesExpTypes("bool")){
-      bool * val1 = myExp1->getBoolValue();
-      bool *val2 = myExp2->getBoolValue();
-      *val = *val1 < *val2;
-    } else if (matchesExpTypes("int")){
-      int *ival1 = myExp1->getIntValue();
-      int *ival2 = myExp2->getIntValue();
-      *val = *ival1 < *ival2;
-    } else if (matchesExpTypes("char")){
-      char *cval1 = myExp1->getCharValue();
-      char *cval2 = myExp2->getCharValue();
-      *val = *cval1 < *cval2;
-    } else {
-    }
-    return val;
-  }
+	bool getBoolValue(Runtime * runtime) override;
 };
 
 class LessEqNode : public BinaryExpNode{
@@ -694,26 +664,10 @@ public:
 	LessEqNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "LessEq"; }
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual bool *getBoolValue() override {
-    bool * val = new bool;
-    if(matchesExpTypes("bool")){
-      bool * val1 = myExp1->getBoolValue();
-      bool *val2 = myExp2->getBoolValue();
-      *val = *val1 <= *val2;
-    } else if (matchesExpTypes("int")){
-      int *ival1 = myExp1->getIntValue();
-      int *ival2 = myExp2->getIntValue();
-      *val = *ival1 <= *ival2;
-    } else if (matchesExpTypes("char")){
-      char *cval1 = myExp1->getCharValue();
-      char *cval2 = myExp2->getCharValue();
-      *val = *cval1 <= *cval2;
-    } else {
-    }
-    return val;
-  }
+	bool getBoolValue(Runtime * runtime) override;
 };
 
 class GreaterNode : public BinaryExpNode{
@@ -722,26 +676,10 @@ public:
 		ExpNode * exp1, ExpNode * exp2)
 	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "GreaterEq"; }
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual bool *getBoolValue() override {
-    bool * val = new bool;
-    if(matchesExpTypes("bool")){
-      bool * val1 = myExp1->getBoolValue();
-      bool *val2 = myExp2->getBoolValue();
-      *val = *val1 > *val2;
-    } else if (matchesExpTypes("int")){
-      int *ival1 = myExp1->getIntValue();
-      int *ival2 = myExp2->getIntValue();
-      *val = *ival1 > *ival2;
-    } else if (matchesExpTypes("char")){
-      char *cval1 = myExp1->getCharValue();
-      char *cval2 = myExp2->getCharValue();
-      *val = *cval1 > *cval2;
-    } else {
-    }
-    return val;
-  }
+	bool getBoolValue(Runtime * runtime) override;
 };
 
 class GreaterEqNode : public BinaryExpNode{
@@ -749,26 +687,10 @@ public:
 	GreaterEqNode(size_t l, size_t c, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(l, c, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "GreaterEq"; }
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual bool *getBoolValue() override {
-       bool * val = new bool;
-    if(matchesExpTypes("bool")){
-      bool * val1 = myExp1->getBoolValue();
-      bool *val2 = myExp2->getBoolValue();
-      *val = *val1 >= *val2;
-    } else if (matchesExpTypes("int")){
-      int *ival1 = myExp1->getIntValue();
-      int *ival2 = myExp2->getIntValue();
-      *val = *ival1 >= *ival2;
-    } else if (matchesExpTypes("char")){
-      char *cval1 = myExp1->getCharValue();
-      char *cval2 = myExp2->getCharValue();
-      *val = *cval1 >= *cval2;
-    } else {
-    }
-    return val;
-  }
+	bool getBoolValue(Runtime * runtime) override;
 };
 
 class UnaryExpNode : public ExpNode {
@@ -777,6 +699,7 @@ public:
 	: ExpNode(lIn, cIn){
 		this->myExp = expIn;
 	}
+	~UnaryExpNode();
 	virtual void unparse(std::ostream& out, int indent) override = 0;
 	virtual bool nameAnalysis(SymbolTable * symTab) override = 0;
 	virtual void typeAnalysis(TypeAnalysis *) override = 0;
@@ -790,15 +713,11 @@ public:
 	NegNode(size_t l, size_t c, ExpNode * exp)
 	: UnaryExpNode(l, c, exp){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "Neg"; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual int *getIntValue() override {
-    int * val = new int; 
-    int * temp = myExp->getIntValue();
-    *val = ((*temp) * -1);
-    return val; 
-  }
+	int getIntValue(Runtime * runtime) override;
 };
 
 class NotNode : public UnaryExpNode{
@@ -806,21 +725,18 @@ public:
 	NotNode(size_t lIn, size_t cIn, ExpNode * exp)
 	: UnaryExpNode(lIn, cIn, exp){ }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "Not"; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual bool *getBoolValue() override { 
-    bool * val = new bool;
-    bool * temp = myExp->getBoolValue();
-    *val = !(*temp);
-    return val;
-  }
+	bool getBoolValue(Runtime * runtime) override;
 };
 
 class VoidTypeNode : public TypeNode{
 public:
 	VoidTypeNode(size_t l, size_t c) : TypeNode(l, c){}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "VoidType"; }
 	virtual DataType * getType()override { 
 		return BasicType::VOID(); 
@@ -832,6 +748,7 @@ class IntTypeNode : public TypeNode{
 public:
 	IntTypeNode(size_t l, size_t c, bool ptrIn): TypeNode(l, c), isPtr(ptrIn){}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "IntType"; }
 	virtual DataType * getType() override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
@@ -843,6 +760,7 @@ class BoolTypeNode : public TypeNode{
 public:
 	BoolTypeNode(size_t l, size_t c, bool ptrIn): TypeNode(l, c), isPtr(ptrIn) { }
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "BoolType"; }
 	virtual DataType * getType() override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
@@ -854,14 +772,26 @@ private:
 class AssignExpNode : public ExpNode{
 public:
 	AssignExpNode(size_t l, size_t c, LValNode * dstIn, ExpNode * srcIn)
-	: ExpNode(l, c), myDst(dstIn), mySrc(srcIn){ }
+	: ExpNode(l, c), myDst(dstIn), mySrc(srcIn),
+	  myDstType(nullptr), mySrcType(nullptr){ }
+	~AssignExpNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "AssignExp"; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	void execute(Runtime * runtime);
+	//An assignment's value is what it stored
+	int getIntValue(Runtime * runtime) override;
+	bool getBoolValue(Runtime * runtime) override;
+	char getCharValue(Runtime * runtime) override;
+	size_t getPtrValue(Runtime * runtime) override;
 private:
 	LValNode * myDst;
 	ExpNode * mySrc;
+	//Set by type analysis, which is not kept around for execution
+	const DataType * myDstType;
+	const DataType * mySrcType;
 };
 
 class IntLitNode : public ExpNode{
@@ -872,14 +802,11 @@ public:
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "IntLit"; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual int *getIntValue() override { 
-    int * val = new int; 
-    *val = myNum; 
-    return val; 
-  }
+	int getIntValue(Runtime *) override { return myNum; }
 
 private:
 	const int myNum;
@@ -888,22 +815,22 @@ private:
 class StrLitNode : public ExpNode{
 public:
 	StrLitNode(size_t l, size_t c, const std::string strIn)
-	: ExpNode(l, c), myStr(strIn){ }
+	: ExpNode(l, c), myStr(strIn), myOffset(0){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "StrLit"; }
 	bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual string *getStrValue() override { 
-    string * val = new string; 
-    *val = myStr; 
-    return val; 
-   }
+	//The literal's address in the runtime's string pool
+	size_t getPtrValue(Runtime * runtime) override;
 
 private:
 	 const std::string myStr;
+	 //Where name analysis put the literal in the pool
+	 size_t myOffset;
 };
 
 class CharLitNode : public ExpNode{
@@ -914,14 +841,12 @@ public:
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "CharLit"; }
 	bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual char *getCharValue() override { 
-    char * val = new char;
-    *val = myVal;
-    return val;
-  }
+	char getCharValue(Runtime *) override { return myVal; }
+
 private:
 	 const char myVal;
 };
@@ -933,9 +858,12 @@ public:
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "NullPtr"; }
 	bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	//The runtime never hands out address 0
+	size_t getPtrValue(Runtime *) override { return 0; }
 };
 
 class TrueNode : public ExpNode{
@@ -945,14 +873,11 @@ public:
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "True"; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual bool * getBoolValue() override {
-    bool * val = new bool;
-    *val = true; 
-    return val;
-  }
+	bool getBoolValue(Runtime *) override { return true; }
 };
 
 class FalseNode : public ExpNode{
@@ -962,25 +887,25 @@ public:
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	virtual std::string nodeKind() override { return "False"; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
-  virtual bool * getBoolValue() override {
-    bool *val = new bool;
-    *val = false;
-    return val;
-  }
+	bool getBoolValue(Runtime *) override { return false; }
 };
 
 class CallStmtNode : public StmtNode{
 public:
 	CallStmtNode(size_t l, size_t c, CallExpNode * expIn)
 	: StmtNode(l, c), myCallExp(expIn){ }
+	~CallStmtNode();
 	void unparse(std::ostream& out, int indent) override;
+	void serialize(ASTWriter& out) override;
 	std::string nodeKind() override { return "CallStmt"; }
 	bool nameAnalysis(SymbolTable * symTab) override;
   virtual CallExpNode * getCallExp() override { return myCallExp; }
 	virtual void typeAnalysis(TypeAnalysis *) override;
+	virtual void execute(Runtime *) override;
   virtual bool isCallStmt() override { return true; }
   virtual bool callFnName(string name) override {
     if(myCallExp->getID()->getName() == name){
@@ -0,0 +1,118 @@
+#include <chrono>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+#include "batch.hpp"
+#include "errors.hpp"
+#include "interpreter.hpp"
+#include "source_file.hpp"
+
+namespace holeyc{
+
+namespace {
+
+//One thread's share of the scripts still to be run
+struct WorkQueue{
+	std::mutex lock;
+	std::deque<size_t> items;
+
+	bool popBack(size_t& item){
+		std::lock_guard<std::mutex> held(lock);
+		if (items.empty()){ return false; }
+		item = items.back();
+		items.pop_back();
+		return true;
+	}
+	bool popFront(size_t& item){
+		std::lock_guard<std::mutex> held(lock);
+		if (items.empty()){ return false; }
+		item = items.front();
+		items.pop_front();
+		return true;
+	}
+};
+
+//No queue grows once the batch has started, so a thread that finds
+// every queue empty can stop
+bool nextItem(std::vector<WorkQueue>& queues, size_t self, size_t& item){
+	if (queues[self].popBack(item)){ return true; }
+	for (size_t i = 1; i < queues.size(); i++){
+		if (queues[(self + i) % queues.size()].popFront(item)){
+			return true;
+		}
+	}
+	return false;
+}
+
+//Everything the script reports is captured, including errors from
+// scanning and parsing it
+void runOne(const std::string& path, const Limits& limits,
+	BatchResult& res){
+	auto start = std::chrono::steady_clock::now();
+	res.path = path;
+	res.ok = false;
+	std::vector<Diagnostic> diags;
+	auto outer = Report::capture(&diags);
+	SourceFile * file = SourceFile::open(path.c_str());
+	if (file == nullptr){
+		Report::error("cannot open " + path);
+	} else {
+		int fd = open((path + ".in").c_str(), O_RDONLY);
+		{
+			Input in(fd);
+			Output out(&res.out);
+			Interpreter interp(in, out);
+			interp.setLimits(limits);
+			//The AST is counted against the interpreter that frees it
+			MemStats::Scope session(&interp.memStats());
+			Scanner scanner(file->data(), file->end());
+			ProgramNode * prog = Interpreter::parse(scanner);
+			//The AST holds copies of everything it needs from the source
+			delete file;
+			if (prog != nullptr){ res.ok = interp.runProgram(prog, 1); }
+		}
+		if (fd >= 0){ close(fd); }
+	}
+	Report::capture(outer);
+	for (const Diagnostic& diag : diags){
+		res.errors += diag.text;
+		res.errors += '\n';
+	}
+	res.ms = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+std::vector<BatchResult> runBatch(const std::vector<std::string>& paths,
+	size_t threads, const Limits& limits){
+	std::vector<BatchResult> results(paths.size());
+	if (threads > paths.size()){ threads = paths.size(); }
+	if (threads == 0){ threads = 1; }
+
+	std::vector<WorkQueue> queues(threads);
+	for (size_t i = 0; i < paths.size(); i++){
+		queues[i * threads / paths.size()].items.push_back(i);
+	}
+
+	auto work = [&](size_t self){
+		size_t item;
+		while (nextItem(queues, self, item)){
+			runOne(paths[item], limits, results[item]);
+		}
+	};
+	std::vector<std::thread> workers;
+	for (size_t t = 1; t < threads; t++){
+		workers.emplace_back(work, t);
+	}
+	work(0);
+	for (std::thread& worker : workers){
+		worker.join();
+	}
+	return results;
+}
+
+}
@@ -0,0 +1,37 @@
+#ifndef HOLEYC_BATCH_HPP
+#define HOLEYC_BATCH_HPP
+
+#include <string>
+#include <vector>
+#include "holeyc.hpp"
+
+namespace holeyc{
+
+//What came of running one script in a batch
+struct BatchResult{
+	std::string path;
+	//Everything the script wrote with TOCONSOLE
+	std::string out;
+	//Its error reports, one per line, in the order they were made
+	std::string errors;
+	//False if the script could not be read, parsed or name analyzed,
+	// or if any of it failed type analysis or faulted
+	bool ok;
+	double ms;
+};
+
+//Run each of paths as a program in an Interpreter of its own, with
+// up to threads scripts running at once, each held to limits. If
+// PATH.in exists it is the script's FROMCONSOLE input; otherwise the
+// script has none.
+//
+//Scripts are dealt out to per-thread queues in contiguous blocks.
+// A thread works from the back of its own queue, and once that is
+// empty it steals from the front of the others', so a run of long
+// scripts on one thread gets spread out over the rest.
+std::vector<BatchResult> runBatch(const std::vector<std::string>& paths,
+	size_t threads, const Limits& limits);
+
+}
+
+#endif
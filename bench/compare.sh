@@ -0,0 +1,39 @@
+#!/bin/sh
+# Compare two result files written by `harness -o`.
+# Usage: bench/compare.sh BASE.json NEW.json
+# Prints the median and peak RSS of each program in both runs
+# and the median speedup (BASE / NEW; above 1 means NEW is faster).
+
+BASE=${1:?usage: compare.sh BASE.json NEW.json}
+NEW=${2:?usage: compare.sh BASE.json NEW.json}
+
+field(){
+	sed -n "s/.*\"$1\":\([^,}]*\).*/\1/p"
+}
+
+extract(){
+	grep '"program"' "$1" | while read -r line; do
+		prog=$(echo "$line" | field program | tr -d '"')
+		med=$(echo "$line" | field median_ms)
+		rss=$(echo "$line" | field peak_rss_kb)
+		ok=$(echo "$line" | field ok)
+		echo "${prog##*/} $med $rss $ok"
+	done
+}
+
+extract "$BASE" > "${TMPDIR:-/tmp}/compare.base.$$"
+extract "$NEW" | awk -v basefile="${TMPDIR:-/tmp}/compare.base.$$" '
+BEGIN {
+	while ((getline line < basefile) > 0) {
+		split(line, f, " ")
+		med[f[1]] = f[2]; rss[f[1]] = f[3]; ok[f[1]] = f[4]
+	}
+	printf "%-28s %11s %11s %8s %12s %12s\n", "program", "base ms", "new ms", "speedup", "base RSS KB", "new RSS KB"
+}
+{
+	if (!($1 in med)) next
+	note = (ok[$1] == "true" && $4 == "true") ? "" : "  (failed run)"
+	speed = ($2 > 0) ? med[$1] / $2 : 0
+	printf "%-28s %11.2f %11.2f %7.2fx %12d %12d%s\n", $1, med[$1], $2, speed, rss[$1], $3, note
+}'
+rm -f "${TMPDIR:-/tmp}/compare.base.$$"
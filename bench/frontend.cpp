@@ -0,0 +1,320 @@
+//Front-end micro-benchmarks. Generates synthetic HoleyC programs
+// of increasing size and times each phase on them in isolation:
+//
+//  scan   Scanner::lex until END (tokens/sec and MB/sec), scanning
+//         the generated text in place
+//  parse  Parser::parse, which drives the scanner itself
+//  name   ProgramNode::nameAnalysis with a fresh SymbolTable
+//  type   ProgramNode::typeAnalysis, which checks every function
+//         body without running it
+//  ptype  TypeAnalysis::checkAll, the same checks spread over -j
+//         threads (default: one per core), as a script is checked
+//
+//  frontend [-s LINES,LINES,...] [-r REPS] [-j THREADS] [-o FILE]
+//  frontend [-r REPS] -f FILE...
+//  frontend --emit LINES
+//
+//Each size is run REPS times and the fastest run is reported.
+// The table goes to stdout; -o also writes it as tab-separated
+// columns for plotting the scaling curve. -f reports scan and parse
+// throughput for existing files instead. --emit writes a generated
+// program to stdout instead of timing anything.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "scanner.hpp"
+#include "ast.hpp"
+#include "symbol_table.hpp"
+#include "string_pool.hpp"
+#include "type_analysis.hpp"
+
+using namespace holeyc;
+
+namespace {
+
+struct Source{
+	std::string text;
+	size_t lines;
+	size_t stmts;
+};
+
+//Emits chained functions until at least targetLines lines have
+// been written. Each function has locals, arithmetic, an if/else,
+// a while loop, a call to its predecessor and a comment, so every
+// token kind the scanner handles in bulk shows up.
+Source generate(size_t targetLines){
+	Source res;
+	res.lines = 0;
+	res.stmts = 0;
+	std::ostringstream out;
+	out << "int g;\n";
+	res.lines++;
+	res.stmts++;
+	for (size_t k = 0; res.lines < targetLines; k++){
+		out << "int f" << k << "(int a, int b){\n"
+			<< "\tint x;\n"
+			<< "\tchar c;\n"
+			<< "\tx = a + b * 2 - " << (k % 97) << ";\n"
+			<< "\tc = 'q;\n"
+			<< "\t# Keep x in range\n"
+			<< "\tif (x > 1000 && b != 0){\n"
+			<< "\t\tx = x / 3;\n"
+			<< "\t} else {\n"
+			<< "\t\tx = x + 1;\n"
+			<< "\t}\n"
+			<< "\twhile (x < 0){\n"
+			<< "\t\tx++;\n"
+			<< "\t}\n";
+		if (k > 0){
+			out << "\tg = f" << (k - 1) << "(x, b);\n";
+			res.lines++;
+			res.stmts++;
+		}
+		out << "\treturn x;\n"
+			<< "}\n";
+		res.lines += 16;
+		res.stmts += 11; //Includes the FnDecl itself
+	}
+	res.text = out.str();
+	return res;
+}
+
+double msSince(std::chrono::steady_clock::time_point start){
+	return std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+struct Timing{
+	size_t tokens;
+	double scanMs;
+	double parseMs;
+	double nameMs;
+	double typeMs;
+	double ptypeMs;
+};
+
+//Scan text to the end, returning the token count. Tokens are
+// plain values, so there is nothing to free.
+size_t scanOnce(const std::string& text, double& ms){
+	Scanner scanner(text.data(), text.data() + text.size());
+	Parser::semantic_type lval;
+	size_t tokens = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (scanner.lex(&lval) != TokenKind::END){
+		tokens++;
+	}
+	ms = msSince(start);
+	return tokens;
+}
+
+ProgramNode * parseOnce(const std::string& text, double& ms){
+	ProgramNode * root = nullptr;
+	Scanner scanner(text.data(), text.data() + text.size());
+	Parser parser(scanner, &root);
+	auto start = std::chrono::steady_clock::now();
+	int err = parser.parse();
+	ms = msSince(start);
+	return err == 0 ? root : nullptr;
+}
+
+//One pass of every phase over src
+bool runPhases(const Source& src, size_t threads, Timing& t){
+	t.tokens = scanOnce(src.text, t.scanMs);
+	ProgramNode * root = parseOnce(src.text, t.parseMs);
+	if (root == nullptr){ return false; }
+
+	StringPool strings;
+	SymbolTable * symTab = new SymbolTable(&strings);
+	auto start = std::chrono::steady_clock::now();
+	bool named = root->nameAnalysis(symTab);
+	t.nameMs = msSince(start);
+	delete symTab;
+	if (!named){ return false; }
+
+	TypeAnalysis * typing = new TypeAnalysis();
+	start = std::chrono::steady_clock::now();
+	root->typeAnalysis(typing);
+	t.typeMs = msSince(start);
+	bool typed = typing->passed();
+	delete typing;
+	if (!typed){ return false; }
+
+	std::vector<StmtNode *> stmts(root->getGlobals()->begin(),
+		root->getGlobals()->end());
+	std::vector<char> passed;
+	start = std::chrono::steady_clock::now();
+	TypeAnalysis::checkAll(stmts, passed, threads);
+	t.ptypeMs = msSince(start);
+	return std::find(passed.begin(), passed.end(), 0) == passed.end();
+}
+
+//Scanner and parser throughput on existing files, such as the
+// bench/programs corpus. Later phases are skipped since they would
+// run the program.
+int measureFiles(const std::vector<const char *>& paths, unsigned reps){
+	std::cout << std::left << std::setw(28) << "file" << std::right
+		<< std::setw(10) << "KB" << std::setw(11) << "Mtok/s"
+		<< std::setw(10) << "scan MB/s" << std::setw(11) << "parse MB/s"
+		<< std::endl << std::fixed << std::setprecision(2);
+	for (const char * path : paths){
+		std::ifstream in(path, std::ios::binary);
+		if (!in){
+			std::cerr << "cannot open " << path << std::endl;
+			return 1;
+		}
+		std::string text((std::istreambuf_iterator<char>(in)),
+			std::istreambuf_iterator<char>());
+		double scanMs = 0;
+		double parseMs = 0;
+		size_t tokens = 0;
+		for (unsigned r = 0; r < reps; r++){
+			double ms;
+			tokens = scanOnce(text, ms);
+			scanMs = r == 0 ? ms : std::min(scanMs, ms);
+			parseOnce(text, ms);
+			parseMs = r == 0 ? ms : std::min(parseMs, ms);
+		}
+		double mb = static_cast<double>(text.size()) / 1e6;
+		std::string name(path);
+		name = name.substr(name.rfind('/') + 1);
+		std::cout << std::left << std::setw(28) << name << std::right
+			<< std::setw(10) << static_cast<double>(text.size()) / 1e3
+			<< std::setw(11) << static_cast<double>(tokens) / 1e3 / scanMs
+			<< std::setw(10) << mb / (scanMs / 1e3)
+			<< std::setw(11) << mb / (parseMs / 1e3) << std::endl;
+	}
+	return 0;
+}
+
+std::vector<size_t> parseSizes(const char * arg){
+	std::vector<size_t> res;
+	std::string s(arg);
+	size_t pos = 0;
+	while (pos < s.size()){
+		size_t comma = s.find(',', pos);
+		if (comma == std::string::npos){ comma = s.size(); }
+		res.push_back(std::strtoul(s.substr(pos, comma - pos).c_str(), nullptr, 10));
+		pos = comma + 1;
+	}
+	return res;
+}
+
+void usage(){
+	std::cerr << "usage: frontend [-s LINES,...] [-r REPS] [-j THREADS]"
+		<< " [-o FILE]\n"
+		<< "       frontend [-r REPS] -f FILE...\n"
+		<< "       frontend --emit LINES" << std::endl;
+	exit(2);
+}
+
+}
+
+int main(int argc, char * argv[]){
+	std::vector<size_t> sizes = { 1000, 10000, 100000, 1000000 };
+	unsigned reps = 3;
+	size_t threads = std::thread::hardware_concurrency();
+	const char * outPath = nullptr;
+	std::vector<const char *> files;
+	for (int i = 1; i < argc; i++){
+		if (strcmp(argv[i], "--emit") == 0 && i + 1 < argc){
+			std::cout << generate(std::strtoul(argv[++i], nullptr, 10)).text;
+			return 0;
+		} else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc){
+			sizes = parseSizes(argv[++i]);
+		} else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc){
+			reps = static_cast<unsigned>(atoi(argv[++i]));
+		} else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc){
+			threads = std::strtoul(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc){
+			outPath = argv[++i];
+		} else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc){
+			while (i + 1 < argc && argv[i + 1][0] != '-'){
+				files.push_back(argv[++i]);
+			}
+		} else {
+			usage();
+		}
+	}
+	if (reps == 0 || sizes.empty()){ usage(); }
+	if (!files.empty()){ return measureFiles(files, reps); }
+
+	std::ofstream tsv;
+	if (outPath){
+		tsv.open(outPath);
+		if (!tsv){
+			std::cerr << "cannot write " << outPath << std::endl;
+			return 1;
+		}
+		tsv << "lines\tbytes\ttokens\tstmts\tscan_ms\tparse_ms"
+			<< "\tname_ms\ttype_ms\tptype_ms\tscan_mtok_s\tscan_mb_s"
+			<< "\tparse_mb_s\tname_us_per_kstmt\ttype_us_per_kstmt"
+			<< "\tptype_us_per_kstmt\n";
+	}
+
+	std::cout << std::setw(9) << "lines" << std::setw(11) << "tokens"
+		<< std::setw(11) << "Mtok/s" << std::setw(10) << "scan MB/s"
+		<< std::setw(11) << "parse MB/s"
+		<< std::setw(15) << "name us/kstmt"
+		<< std::setw(15) << "type us/kstmt"
+		<< std::setw(16) << ("type -j" + std::to_string(threads)) << std::endl;
+	std::cout << std::fixed;
+
+	for (size_t lines : sizes){
+		Source src = generate(lines);
+		Timing best = Timing();
+		for (unsigned r = 0; r < reps; r++){
+			Timing t;
+			if (!runPhases(src, threads, t)){
+				std::cerr << "generated program failed to compile" << std::endl;
+				return 1;
+			}
+			if (r == 0){
+				best = t;
+				continue;
+			}
+			best.scanMs = std::min(best.scanMs, t.scanMs);
+			best.parseMs = std::min(best.parseMs, t.parseMs);
+			best.nameMs = std::min(best.nameMs, t.nameMs);
+			best.typeMs = std::min(best.typeMs, t.typeMs);
+			best.ptypeMs = std::min(best.ptypeMs, t.ptypeMs);
+		}
+
+		double mb = static_cast<double>(src.text.size()) / 1e6;
+		double kstmts = static_cast<double>(src.stmts) / 1e3;
+		double mtokPerSec = static_cast<double>(best.tokens) / 1e3 / best.scanMs;
+		double scanMBs = mb / (best.scanMs / 1e3);
+		double parseMBs = mb / (best.parseMs / 1e3);
+		double nameUs = best.nameMs * 1e3 / kstmts;
+		double typeUs = best.typeMs * 1e3 / kstmts;
+		double ptypeUs = best.ptypeMs * 1e3 / kstmts;
+
+		std::cout << std::setw(9) << src.lines << std::setw(11) << best.tokens
+			<< std::setprecision(2)
+			<< std::setw(11) << mtokPerSec << std::setw(10) << scanMBs
+			<< std::setw(11) << parseMBs
+			<< std::setprecision(1)
+			<< std::setw(15) << nameUs << std::setw(15) << typeUs
+			<< std::setw(16) << ptypeUs << std::endl;
+		if (tsv.is_open()){
+			tsv << src.lines << '\t' << src.text.size() << '\t' << best.tokens
+				<< '\t' << src.stmts << std::fixed << std::setprecision(3)
+				<< '\t' << best.scanMs << '\t' << best.parseMs
+				<< '\t' << best.nameMs << '\t' << best.typeMs
+				<< '\t' << best.ptypeMs
+				<< '\t' << mtokPerSec << '\t' << scanMBs << '\t' << parseMBs
+				<< '\t' << nameUs << '\t' << typeUs << '\t' << ptypeUs << '\n';
+		}
+	}
+	return 0;
+}
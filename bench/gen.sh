@@ -0,0 +1,31 @@
+#!/bin/sh
+# Generate the benchmark programs that are too large to keep in
+# the repository. Usage: bench/gen.sh OUTDIR [FUNCTIONS]
+
+OUT=${1:?usage: gen.sh OUTDIR [FUNCTIONS]}
+FUNCTIONS=${2:-2000}
+mkdir -p "$OUT"
+
+# Many small functions, each calling the previous one. Stresses
+# per-declaration costs in the front end and the call path.
+awk -v n="$FUNCTIONS" 'BEGIN {
+	print "# Generated by bench/gen.sh: " n " chained functions."
+	print "int f0(int x){"
+	print "\treturn x + 1;"
+	print "}"
+	for (i = 1; i < n; i++) {
+		print "int f" i "(int x){"
+		print "\tint y;"
+		print "\ty = x + " (i % 7) ";"
+		print "\tif (y > 1000){"
+		print "\t\ty = y - 1000;"
+		print "\t}"
+		print "\treturn f" (i - 1) "(y);"
+		print "}"
+	}
+	print "int res;"
+	for (i = 0; i < n; i += 50) {
+		print "res = f" i "(" i ");"
+	}
+	print "TOCONSOLE res;"
+}' > "$OUT/many_functions.holeyc"
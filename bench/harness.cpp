@@ -0,0 +1,429 @@
+//Benchmark harness: runs each program through an interpreter
+// binary several times and reports wall time and peak RSS.
+//
+//  harness [-n RUNS] [-w WARMUP] [-o FILE] [-l LABEL] [-a ARG]... [-c]
+//          INTERP PROGRAM...
+//
+//Each -a ARG is passed to INTERP ahead of the program (to compare
+// runs with and without an interpreter option, say).
+//With -c, each run also counts cycles, instructions, branch misses
+// and cache misses in each phase (scan, parse, analyze, execute),
+// through INTERP's --counters, and the median of each is reported.
+// Where the system has no counters to give, that is said once and
+// the runs are timed as usual.
+//Each run is a fresh process with stdout and stderr sent to
+// /dev/null. If PROGRAM.in exists it is used as stdin, otherwise
+// stdin is /dev/null. The summary table goes to stdout; with -o
+// the full results, including every sample, are written as JSON
+// so that two builds can be compared with bench/compare.sh.
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+//What one run's --counters file said: each phase's count of each
+// event, or -1 where the event was not counted, and whether any of
+// the phase's counts were estimated
+struct Counts{
+	std::vector<std::string> phases;
+	std::vector<std::vector<double>> vals;
+	std::vector<bool> estimated;
+	std::string unavailable;
+};
+
+struct Sample{
+	double ms;
+	long rssKB;
+	int status;
+	Counts counts;
+};
+
+struct Result{
+	std::string program;
+	std::vector<Sample> samples;
+	bool ok;
+	int failStatus;
+};
+
+const char * EVENTS[] = {
+	"cycles", "instructions", "branch_misses", "cache_misses"
+};
+const size_t NUM_EVENTS = sizeof(EVENTS) / sizeof(EVENTS[0]);
+
+void usage(){
+	std::cerr << "usage: harness [-n RUNS] [-w WARMUP] [-o FILE]"
+		<< " [-l LABEL] [-a ARG]... [-c] INTERP PROGRAM..." << std::endl;
+	exit(2);
+}
+
+int openOr(const std::string& path, const char * fallback, int flags){
+	int fd = open(path.c_str(), flags);
+	if (fd < 0){ fd = open(fallback, flags); }
+	return fd;
+}
+
+Counts readCounts(const std::string& path){
+	Counts res;
+	std::ifstream in(path);
+	std::string line;
+	while (std::getline(in, line)){
+		if (line.empty() || line[0] == '#'){ continue; }
+		std::vector<std::string> fields;
+		size_t start = 0;
+		size_t tab;
+		while ((tab = line.find('\t', start)) != std::string::npos){
+			fields.push_back(line.substr(start, tab - start));
+			start = tab + 1;
+		}
+		fields.push_back(line.substr(start));
+		if (fields[0] == "unavailable"){
+			res.unavailable = fields.size() > 1 ? fields[1] : "unknown";
+			return res;
+		}
+		std::vector<double> vals;
+		for (size_t i = 1; i <= NUM_EVENTS; i++){
+			vals.push_back(i < fields.size() && fields[i] != "-"
+				? strtod(fields[i].c_str(), nullptr) : -1);
+		}
+		res.phases.push_back(fields[0]);
+		res.vals.push_back(vals);
+		res.estimated.push_back(NUM_EVENTS + 1 < fields.size()
+			&& fields[NUM_EVENTS + 1] != "-");
+	}
+	if (res.phases.empty()){ res.unavailable = "no counts written"; }
+	return res;
+}
+
+//Fork and exec one run, timing it from just before fork to the
+// return of wait4. ru_maxrss is the child's own high-water mark.
+// If countersPath is given, the run's counts are written there.
+Sample runOnce(const std::string& interp,
+	const std::vector<std::string>& args, const std::string& program,
+	const std::string& countersPath){
+	Sample res;
+	res.ms = 0;
+	res.rssKB = 0;
+	res.status = -1;
+
+	auto start = std::chrono::steady_clock::now();
+	pid_t pid = fork();
+	if (pid < 0){
+		std::cerr << "fork: " << strerror(errno) << std::endl;
+		return res;
+	}
+	if (pid == 0){
+		int in = openOr(program + ".in", "/dev/null", O_RDONLY);
+		int out = open("/dev/null", O_WRONLY);
+		if (in < 0 || out < 0){ _exit(127); }
+		dup2(in, 0);
+		dup2(out, 1);
+		dup2(out, 2);
+		std::vector<char *> argv;
+		argv.push_back(const_cast<char *>(interp.c_str()));
+		for (const std::string& arg : args){
+			argv.push_back(const_cast<char *>(arg.c_str()));
+		}
+		if (!countersPath.empty()){
+			argv.push_back(const_cast<char *>("--counters"));
+			argv.push_back(const_cast<char *>(countersPath.c_str()));
+		}
+		argv.push_back(const_cast<char *>(program.c_str()));
+		argv.push_back(nullptr);
+		execv(interp.c_str(), argv.data());
+		_exit(127);
+	}
+
+	int status = 0;
+	struct rusage usage;
+	while (wait4(pid, &status, 0, &usage) < 0){
+		if (errno != EINTR){
+			std::cerr << "wait4: " << strerror(errno) << std::endl;
+			return res;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	res.ms = std::chrono::duration<double, std::milli>(end - start).count();
+	res.rssKB = usage.ru_maxrss;
+	res.status = status;
+	if (!countersPath.empty()){ res.counts = readCounts(countersPath); }
+	return res;
+}
+
+//Nearest-rank percentile over an already sorted vector.
+double percentile(const std::vector<double>& sorted, double pct){
+	if (sorted.empty()){ return 0; }
+	size_t rank = static_cast<size_t>(pct / 100.0
+		* static_cast<double>(sorted.size()) + 0.999999);
+	if (rank == 0){ rank = 1; }
+	if (rank > sorted.size()){ rank = sorted.size(); }
+	return sorted[rank - 1];
+}
+
+std::vector<double> sortedTimes(const Result& r){
+	std::vector<double> res;
+	for (const Sample& s : r.samples){ res.push_back(s.ms); }
+	std::sort(res.begin(), res.end());
+	return res;
+}
+
+//The median count of each event in each phase, over the runs that
+// counted it (-1 if none did), in the phases of the first run. A
+// phase is estimated if it was in any run. Empty if counting was
+// unavailable.
+Counts medianCounts(const Result& r){
+	Counts res;
+	for (const Sample& s : r.samples){
+		if (!s.counts.unavailable.empty()){
+			res.unavailable = s.counts.unavailable;
+			return res;
+		}
+	}
+	if (r.samples.empty()){ return res; }
+	res.phases = r.samples.front().counts.phases;
+	for (size_t p = 0; p < res.phases.size(); p++){
+		bool estimated = false;
+		for (const Sample& s : r.samples){
+			if (p < s.counts.estimated.size() && s.counts.estimated[p]){
+				estimated = true;
+			}
+		}
+		res.estimated.push_back(estimated);
+		std::vector<double> vals;
+		for (size_t e = 0; e < NUM_EVENTS; e++){
+			std::vector<double> counted;
+			for (const Sample& s : r.samples){
+				if (p < s.counts.vals.size() && s.counts.vals[p][e] >= 0){
+					counted.push_back(s.counts.vals[p][e]);
+				}
+			}
+			std::sort(counted.begin(), counted.end());
+			vals.push_back(counted.empty() ? -1 : percentile(counted, 50));
+		}
+		res.vals.push_back(vals);
+	}
+	return res;
+}
+
+long peakRSS(const Result& r){
+	long res = 0;
+	for (const Sample& s : r.samples){ res = std::max(res, s.rssKB); }
+	return res;
+}
+
+//A row for each phase under a program's timings. Should there be
+// no counters, that is only said the first time.
+void printCounts(const Counts& counts, bool& warned){
+	if (!counts.unavailable.empty()){
+		if (!warned){
+			std::cout << "  (no hardware counters: " << counts.unavailable
+				<< ")" << std::endl;
+			warned = true;
+		}
+		return;
+	}
+	for (size_t p = 0; p < counts.phases.size(); p++){
+		const std::vector<double>& vals = counts.vals[p];
+		std::cout << std::left << std::setw(12) << "  " + counts.phases[p]
+			<< std::right << std::setprecision(0);
+		for (size_t e = 0; e < NUM_EVENTS; e++){
+			if (e == 2){
+				std::cout << std::setprecision(2) << std::setw(8);
+				if (vals[0] > 0 && vals[1] >= 0){
+					std::cout << vals[1] / vals[0];
+				} else {
+					std::cout << "-";
+				}
+				std::cout << std::setprecision(0);
+			}
+			std::cout << std::setw(16);
+			if (vals[e] < 0){
+				std::cout << "-";
+			} else {
+				std::cout << vals[e];
+			}
+		}
+		if (counts.estimated[p]){ std::cout << "  (estimated)"; }
+		std::cout << std::endl;
+	}
+}
+
+std::string describe(int status){
+	if (WIFEXITED(status)){
+		return "exit " + std::to_string(WEXITSTATUS(status));
+	}
+	if (WIFSIGNALED(status)){
+		return "signal " + std::to_string(WTERMSIG(status));
+	}
+	return "status " + std::to_string(status);
+}
+
+std::string jsonStr(const std::string& s){
+	std::string res = "\"";
+	for (char ch : s){
+		if (ch == '"' || ch == '\\'){ res += '\\'; }
+		res += ch;
+	}
+	return res + "\"";
+}
+
+void writeJSON(std::ostream& out, const std::string& label,
+	const std::string& interp, unsigned runs, bool counting,
+	const std::vector<Result>& results){
+	out << std::fixed << std::setprecision(3);
+	out << "{\"label\":" << jsonStr(label)
+		<< ",\"interpreter\":" << jsonStr(interp)
+		<< ",\"runs\":" << runs
+		<< ",\"results\":[";
+	bool first = true;
+	for (const Result& r : results){
+		std::vector<double> times = sortedTimes(r);
+		out << (first ? "" : ",") << "\n {\"program\":" << jsonStr(r.program)
+			<< ",\"ok\":" << (r.ok ? "true" : "false");
+		if (!r.ok){
+			out << ",\"failure\":" << jsonStr(describe(r.failStatus));
+		}
+		out << ",\"median_ms\":" << percentile(times, 50)
+			<< ",\"p95_ms\":" << percentile(times, 95)
+			<< ",\"min_ms\":" << (times.empty() ? 0 : times.front())
+			<< ",\"max_ms\":" << (times.empty() ? 0 : times.back())
+			<< ",\"peak_rss_kb\":" << peakRSS(r)
+			<< ",\"samples_ms\":[";
+		for (size_t i = 0; i < r.samples.size(); i++){
+			out << (i == 0 ? "" : ",") << r.samples[i].ms;
+		}
+		out << "]";
+		Counts counts = counting ? medianCounts(r) : Counts();
+		if (!counts.unavailable.empty()){
+			out << ",\"counters_unavailable\":" << jsonStr(counts.unavailable);
+		} else if (counting){
+			out << std::setprecision(0) << ",\"counters\":{";
+			for (size_t p = 0; p < counts.phases.size(); p++){
+				out << (p == 0 ? "" : ",") << jsonStr(counts.phases[p]) << ":{";
+				for (size_t e = 0; e < NUM_EVENTS; e++){
+					out << (e == 0 ? "" : ",") << "\"" << EVENTS[e] << "\":";
+					if (counts.vals[p][e] < 0){
+						out << "null";
+					} else {
+						out << counts.vals[p][e];
+					}
+				}
+				if (counts.estimated[p]){ out << ",\"estimated\":true"; }
+				out << "}";
+			}
+			out << "}" << std::setprecision(3);
+		}
+		out << "}";
+		first = false;
+	}
+	out << "\n]}\n";
+}
+
+}
+
+int main(int argc, char * argv[]){
+	unsigned runs = 10;
+	unsigned warmup = 1;
+	std::string outPath;
+	std::string label;
+	std::vector<std::string> args;
+	bool counting = false;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "+n:w:o:l:a:c")) != -1){
+		switch (opt){
+		case 'n': runs = static_cast<unsigned>(atoi(optarg)); break;
+		case 'w': warmup = static_cast<unsigned>(atoi(optarg)); break;
+		case 'o': outPath = optarg; break;
+		case 'l': label = optarg; break;
+		case 'a': args.push_back(optarg); break;
+		case 'c': counting = true; break;
+		default: usage();
+		}
+	}
+	if (runs == 0 || argc - optind < 2){ usage(); }
+	std::string interp = argv[optind];
+	if (label.empty()){ label = interp; }
+	std::string countersPath;
+	if (counting){
+		const char * tmp = getenv("TMPDIR");
+		std::string pattern = std::string(tmp ? tmp : "/tmp")
+			+ "/harness-counters.XXXXXX";
+		std::vector<char> name(pattern.begin(), pattern.end());
+		name.push_back('\0');
+		int fd = mkstemp(name.data());
+		if (fd < 0){
+			std::cerr << "mkstemp: " << strerror(errno) << std::endl;
+			return 1;
+		}
+		close(fd);
+		countersPath = name.data();
+	}
+	bool warned = false;
+
+	std::vector<Result> results;
+	std::cout << std::left << std::setw(28) << "program"
+		<< std::right << std::setw(12) << "median ms"
+		<< std::setw(12) << "p95 ms"
+		<< std::setw(14) << "peak RSS KB" << std::endl;
+	if (counting){
+		std::cout << std::left << std::setw(12) << "  phase"
+			<< std::right << std::setw(16) << "cycles"
+			<< std::setw(16) << "instructions" << std::setw(8) << "IPC"
+			<< std::setw(16) << "branch misses"
+			<< std::setw(16) << "cache misses" << std::endl;
+	}
+	for (int i = optind + 1; i < argc; i++){
+		Result r;
+		r.program = argv[i];
+		r.ok = true;
+		r.failStatus = 0;
+		for (unsigned w = 0; w < warmup; w++){
+			runOnce(interp, args, r.program, countersPath);
+		}
+		for (unsigned n = 0; n < runs; n++){
+			Sample s = runOnce(interp, args, r.program, countersPath);
+			if (!WIFEXITED(s.status) || WEXITSTATUS(s.status) != 0){
+				r.ok = false;
+				r.failStatus = s.status;
+			}
+			r.samples.push_back(s);
+		}
+
+		std::vector<double> times = sortedTimes(r);
+		std::string name = r.program.substr(r.program.rfind('/') + 1);
+		std::cout << std::left << std::setw(28) << name << std::right
+			<< std::fixed << std::setprecision(2)
+			<< std::setw(12) << percentile(times, 50)
+			<< std::setw(12) << percentile(times, 95)
+			<< std::setw(14) << peakRSS(r);
+		if (!r.ok){ std::cout << "  FAILED (" << describe(r.failStatus) << ")"; }
+		std::cout << std::endl;
+		if (counting){ printCounts(medianCounts(r), warned); }
+		results.push_back(r);
+	}
+
+	if (!outPath.empty()){
+		std::ofstream out(outPath);
+		if (!out){
+			std::cerr << "cannot write " << outPath << std::endl;
+			return 1;
+		}
+		writeJSON(out, label, interp, runs, counting, results);
+	}
+	if (counting){ unlink(countersPath.c_str()); }
+	return 0;
+}
@@ -0,0 +1,38 @@
+#!/bin/sh
+# Measure TOCONSOLE throughput in lines/sec.
+#
+# Generates a program whose function body prints STMTS values and
+# calls it CALLS times, then times a run of the given interpreter with
+# its output sent to a file. Run it once against a build from before a
+# change and once after to compare:
+#
+#   bench/toconsole.sh ./dragoninterp-old
+#   bench/toconsole.sh ./dragoninterp
+#
+# Usage: bench/toconsole.sh [INTERP] [STMTS] [CALLS]
+
+INTERP=${1:-./dragoninterp}
+STMTS=${2:-1000}
+CALLS=${3:-200}
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+awk -v stmts="$STMTS" -v calls="$CALLS" 'BEGIN {
+	print "int n;"
+	print "n = 1234567;"
+	print "void emit(){"
+	for (i = 0; i < stmts; i++) { print "\tTOCONSOLE n;" }
+	print "}"
+	for (i = 0; i < calls; i++) { print "emit();" }
+}' > "$WORK/toconsole.holeyc"
+
+start=$(date +%s.%N)
+"$INTERP" "$WORK/toconsole.holeyc" > "$WORK/out.txt" || exit 1
+end=$(date +%s.%N)
+
+lines=$(wc -l < "$WORK/out.txt")
+awk -v l="$lines" -v s="$start" -v e="$end" 'BEGIN {
+	t = e - s
+	printf "%d lines in %.3f s: %.0f lines/sec\n", l, t, l / t
+}'
@@ -0,0 +1,346 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "code_cache.hpp"
+
+namespace holeyc{
+
+static const char * CACHE_MAGIC = "HYCC";
+
+void ASTWriter::node(ASTNode * node){
+	if (node == nullptr){
+		byte(TAG_NONE);
+		return;
+	}
+	node->serialize(*this);
+}
+
+void ASTWriter::header(ASTTag tag, const ASTNode * node){
+	byte(tag);
+	num(node->line());
+	num(node->col());
+}
+
+//Unsigned LEB128: 7 bits per byte, high bit set on all but
+// the last byte. Positions and list lengths are almost always
+// a single byte.
+void ASTWriter::num(uint64_t val){
+	while (val >= 0x80){
+		byte(static_cast<unsigned char>((val & 0x7f) | 0x80));
+		val >>= 7;
+	}
+	byte(static_cast<unsigned char>(val));
+}
+
+void ASTWriter::str(const std::string& s){
+	num(s.size());
+	myBuf.append(s);
+}
+
+unsigned char ASTReader::byte(){
+	if (pos == end){
+		hasError = true;
+		return 0;
+	}
+	return static_cast<unsigned char>(*pos++);
+}
+
+uint64_t ASTReader::num(){
+	uint64_t res = 0;
+	for (unsigned int shift = 0; shift < 64; shift += 7){
+		unsigned char b = byte();
+		res |= static_cast<uint64_t>(b & 0x7f) << shift;
+		if ((b & 0x80) == 0){ return res; }
+	}
+	hasError = true;
+	return 0;
+}
+
+std::string ASTReader::str(){
+	uint64_t len = num();
+	if (len > static_cast<uint64_t>(end - pos)){
+		hasError = true;
+		return "";
+	}
+	std::string res(pos, static_cast<size_t>(len));
+	pos += len;
+	return res;
+}
+
+bool ASTReader::sameStr(const char * src, size_t len){
+	uint64_t strLen = num();
+	if (hasError || strLen > static_cast<uint64_t>(end - pos)){
+		hasError = true;
+		return false;
+	}
+	bool res = strLen == len && memcmp(pos, src, len) == 0;
+	pos += strLen;
+	return res;
+}
+
+template <typename T>
+T * ASTReader::expect(ASTNode * node){
+	T * res = dynamic_cast<T *>(node);
+	if (res == nullptr){ hasError = true; }
+	return res;
+}
+
+template <typename T>
+std::list<T *> * ASTReader::list(T * (ASTReader::*readElt)()){
+	std::list<T *> * res = new std::list<T *>();
+	uint64_t count = num();
+	for (uint64_t i = 0; i < count && !hasError; i++){
+		res->push_back((this->*readElt)());
+	}
+	return res;
+}
+
+ProgramNode * ASTReader::program(){
+	return expect<ProgramNode>(node());
+}
+
+StmtNode * ASTReader::stmt(){ return expect<StmtNode>(node()); }
+ExpNode * ASTReader::exp(){ return expect<ExpNode>(node()); }
+LValNode * ASTReader::lval(){ return expect<LValNode>(node()); }
+IDNode * ASTReader::id(){ return expect<IDNode>(node()); }
+TypeNode * ASTReader::type(){ return expect<TypeNode>(node()); }
+FormalDeclNode * ASTReader::formal(){
+	return expect<FormalDeclNode>(node());
+}
+
+//Children are read into locals before each constructor call
+// since the order in which arguments are evaluated is unspecified.
+ASTNode * ASTReader::node(){
+	unsigned char tag = byte();
+	if (hasError || tag == TAG_NONE){ return nullptr; }
+	size_t l = num();
+	size_t c = num();
+	if (hasError){ return nullptr; }
+
+	switch(tag){
+	case TAG_PROGRAM:
+		return new ProgramNode(list(&ASTReader::stmt));
+	case TAG_ID:
+		return new IDNode(l, c, str());
+	case TAG_REF:
+		return new RefNode(l, c, id());
+	case TAG_DEREF:
+		return new DerefNode(l, c, id());
+	case TAG_INDEX: {
+		IDNode * base = id();
+		ExpNode * offset = exp();
+		return new IndexNode(l, c, base, offset);
+	}
+	case TAG_VOIDTYPE:
+		return new VoidTypeNode(l, c);
+	case TAG_INTTYPE:
+		return new IntTypeNode(l, c, byte() != 0);
+	case TAG_BOOLTYPE:
+		return new BoolTypeNode(l, c, byte() != 0);
+	case TAG_CHARTYPE:
+		return new CharTypeNode(l, c, byte() != 0);
+	case TAG_VARDECL: {
+		TypeNode * declType = type();
+		IDNode * declID = id();
+		return new VarDeclNode(l, c, declType, declID);
+	}
+	case TAG_FORMALDECL: {
+		TypeNode * declType = type();
+		IDNode * declID = id();
+		return new FormalDeclNode(l, c, declType, declID);
+	}
+	case TAG_FNDECL: {
+		TypeNode * retType = type();
+		IDNode * fnID = id();
+		std::list<FormalDeclNode *> * formals = list(&ASTReader::formal);
+		std::list<StmtNode *> * body = list(&ASTReader::stmt);
+		return new FnDeclNode(l, c, retType, fnID, formals, body);
+	}
+	case TAG_ASSIGNSTMT:
+		return new AssignStmtNode(l, c, expect<AssignExpNode>(node()));
+	case TAG_FROMCONSOLE:
+		return new FromConsoleStmtNode(l, c, lval());
+	case TAG_TOCONSOLE:
+		return new ToConsoleStmtNode(l, c, exp());
+	case TAG_POSTDEC:
+		return new PostDecStmtNode(l, c, lval());
+	case TAG_POSTINC:
+		return new PostIncStmtNode(l, c, lval());
+	case TAG_IF: {
+		ExpNode * cond = exp();
+		std::list<StmtNode *> * body = list(&ASTReader::stmt);
+		return new IfStmtNode(l, c, cond, body);
+	}
+	case TAG_IFELSE: {
+		ExpNode * cond = exp();
+		std::list<StmtNode *> * bodyTrue = list(&ASTReader::stmt);
+		std::list<StmtNode *> * bodyFalse = list(&ASTReader::stmt);
+		return new IfElseStmtNode(l, c, cond, bodyTrue, bodyFalse);
+	}
+	case TAG_WHILE: {
+		ExpNode * cond = exp();
+		std::list<StmtNode *> * body = list(&ASTReader::stmt);
+		return new WhileStmtNode(l, c, cond, body);
+	}
+	case TAG_RETURN: {
+		ASTNode * retExp = node();
+		if (retExp == nullptr){
+			return new ReturnStmtNode(l, c, nullptr);
+		}
+		return new ReturnStmtNode(l, c, expect<ExpNode>(retExp));
+	}
+	case TAG_CALLSTMT:
+		return new CallStmtNode(l, c, expect<CallExpNode>(node()));
+	case TAG_CALLEXP: {
+		IDNode * callee = id();
+		std::list<ExpNode *> * args = list(&ASTReader::exp);
+		return new CallExpNode(l, c, callee, args);
+	}
+	case TAG_ASSIGNEXP: {
+		LValNode * dst = lval();
+		ExpNode * src = exp();
+		return new AssignExpNode(l, c, dst, src);
+	}
+	case TAG_NEG:
+		return new NegNode(l, c, exp());
+	case TAG_NOT:
+		return new NotNode(l, c, exp());
+	case TAG_INTLIT:
+		return new IntLitNode(l, c,
+			static_cast<int>(static_cast<unsigned int>(num())));
+	case TAG_STRLIT:
+		return new StrLitNode(l, c, str());
+	case TAG_CHARLIT:
+		return new CharLitNode(l, c, static_cast<char>(byte()));
+	case TAG_NULLPTR:
+		return new NullPtrNode(l, c);
+	case TAG_TRUE:
+		return new TrueNode(l, c);
+	case TAG_FALSE:
+		return new FalseNode(l, c);
+	default:
+		break;
+	}
+
+	ExpNode * lhs = exp();
+	ExpNode * rhs = exp();
+	switch(tag){
+	case TAG_PLUS: return new PlusNode(l, c, lhs, rhs);
+	case TAG_MINUS: return new MinusNode(l, c, lhs, rhs);
+	case TAG_TIMES: return new TimesNode(l, c, lhs, rhs);
+	case TAG_DIVIDE: return new DivideNode(l, c, lhs, rhs);
+	case TAG_AND: return new AndNode(l, c, lhs, rhs);
+	case TAG_OR: return new OrNode(l, c, lhs, rhs);
+	case TAG_EQUALS: return new EqualsNode(l, c, lhs, rhs);
+	case TAG_NOTEQUALS: return new NotEqualsNode(l, c, lhs, rhs);
+	case TAG_LESS: return new LessNode(l, c, lhs, rhs);
+	case TAG_LESSEQ: return new LessEqNode(l, c, lhs, rhs);
+	case TAG_GREATER: return new GreaterNode(l, c, lhs, rhs);
+	case TAG_GREATEREQ: return new GreaterEqNode(l, c, lhs, rhs);
+	default:
+		hasError = true;
+		return nullptr;
+	}
+}
+
+CodeCache::CodeCache(std::string dirIn)
+: dir(dirIn), dirReady(false),
+  hits(0), misses(0), stale(0), stores(0){
+}
+
+//64-bit FNV-1a. It only picks the file: the source stored in the
+// entry is what decides a hit.
+uint64_t CodeCache::hash(const char * src, size_t len){
+	uint64_t res = 14695981039346656037ULL;
+	for (size_t i = 0; i < len; i++){
+		res ^= static_cast<unsigned char>(src[i]);
+		res *= 1099511628211ULL;
+	}
+	return res;
+}
+
+std::string CodeCache::pathFor(uint64_t key) const{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.hcc",
+		static_cast<unsigned long long>(key));
+	return dir + "/" + name;
+}
+
+ProgramNode * CodeCache::lookup(const char * src, size_t len){
+	uint64_t key = hash(src, len);
+	std::ifstream in(pathFor(key), std::ios::binary);
+	if (!in){
+		misses++;
+		return nullptr;
+	}
+	std::string bytes((std::istreambuf_iterator<char>(in)),
+		std::istreambuf_iterator<char>());
+
+	ASTReader reader(bytes.data(), bytes.data() + bytes.size());
+	bool fresh = reader.str() == CACHE_MAGIC
+		&& reader.num() == FORMAT_VERSION
+		&& reader.str() == DRAGONINTERP_VERSION
+		&& reader.num() == key
+		&& reader.sameStr(src, len);
+	ProgramNode * prog = fresh ? reader.program() : nullptr;
+	if (prog == nullptr || reader.failed() || !reader.atEnd()){
+		//Written by another version, or corrupt. Either way
+		// it will be overwritten by the store that follows.
+		stale++;
+		misses++;
+		return nullptr;
+	}
+	hits++;
+	return prog;
+}
+
+void CodeCache::store(const char * src, size_t len, ProgramNode * prog){
+	if (!dirReady){
+		if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST){
+			return;
+		}
+		dirReady = true;
+	}
+
+	uint64_t key = hash(src, len);
+	ASTWriter out;
+	out.str(CACHE_MAGIC);
+	out.num(FORMAT_VERSION);
+	out.str(DRAGONINTERP_VERSION);
+	out.num(key);
+	out.str(std::string(src, len));
+	out.node(prog);
+
+	//Write to a private temp file and rename it into place so
+	// that concurrent runs never observe a partial entry.
+	std::string path = pathFor(key);
+	std::string tmpPath = path + "." + std::to_string(getpid());
+	{
+		std::ofstream tmp(tmpPath, std::ios::binary | std::ios::trunc);
+		if (!tmp){ return; }
+		tmp.write(out.bytes().data(),
+			static_cast<std::streamsize>(out.bytes().size()));
+		if (!tmp){
+			std::remove(tmpPath.c_str());
+			return;
+		}
+	}
+	if (std::rename(tmpPath.c_str(), path.c_str()) != 0){
+		std::remove(tmpPath.c_str());
+		return;
+	}
+	stores++;
+}
+
+void CodeCache::printStats(std::ostream& out) const{
+	out << "cache: " << hits << " hits, "
+		<< misses << " misses (" << stale << " stale), "
+		<< stores << " stores [" << dir << "]" << std::endl;
+}
+
+}
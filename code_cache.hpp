@@ -0,0 +1,124 @@
+#ifndef HOLEYC_CODE_CACHE_HPP
+#define HOLEYC_CODE_CACHE_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include "ast.hpp"
+
+//Bump DRAGONINTERP_VERSION with every release. Cache entries
+// written by any other version are treated as stale.
+#define DRAGONINTERP_VERSION "0.2.0"
+
+namespace holeyc{
+
+//One tag per concrete AST node kind. The numeric values are
+// part of the on-disk format: append new tags at the end and
+// bump CodeCache::FORMAT_VERSION if an existing encoding changes.
+enum ASTTag : unsigned char {
+	TAG_NONE = 0,
+	TAG_PROGRAM,
+	TAG_ID, TAG_REF, TAG_DEREF, TAG_INDEX,
+	TAG_VOIDTYPE, TAG_INTTYPE, TAG_BOOLTYPE, TAG_CHARTYPE,
+	TAG_VARDECL, TAG_FORMALDECL, TAG_FNDECL,
+	TAG_ASSIGNSTMT, TAG_FROMCONSOLE, TAG_TOCONSOLE,
+	TAG_POSTDEC, TAG_POSTINC,
+	TAG_IF, TAG_IFELSE, TAG_WHILE, TAG_RETURN, TAG_CALLSTMT,
+	TAG_CALLEXP, TAG_ASSIGNEXP,
+	TAG_PLUS, TAG_MINUS, TAG_TIMES, TAG_DIVIDE,
+	TAG_AND, TAG_OR,
+	TAG_EQUALS, TAG_NOTEQUALS,
+	TAG_LESS, TAG_LESSEQ, TAG_GREATER, TAG_GREATEREQ,
+	TAG_NEG, TAG_NOT,
+	TAG_INTLIT, TAG_STRLIT, TAG_CHARLIT,
+	TAG_NULLPTR, TAG_TRUE, TAG_FALSE,
+	TAG_LAST
+};
+
+//Flattens an AST into a compact byte string. Each node is
+// written as its tag, its position, and then its children in
+// constructor order (see ASTNode::serialize in serialize.cpp).
+class ASTWriter{
+public:
+	void node(ASTNode * node);
+	void header(ASTTag tag, const ASTNode * node);
+	void byte(unsigned char b){ myBuf.push_back(static_cast<char>(b)); }
+	void num(uint64_t val);
+	void str(const std::string& s);
+	template <typename T>
+	void nodes(const std::list<T *> * list){
+		num(list->size());
+		for (T * elt : *list){ node(elt); }
+	}
+	const std::string& bytes() const { return myBuf; }
+private:
+	std::string myBuf;
+};
+
+//Rebuilds an AST from the bytes produced by ASTWriter. A
+// truncated or corrupt buffer never crashes the reader: it
+// sets the failed flag and the caller discards the result.
+class ASTReader{
+public:
+	ASTReader(const char * beginIn, const char * endIn)
+	: pos(beginIn), end(endIn), hasError(false){ }
+	ProgramNode * program();
+	unsigned char byte();
+	uint64_t num();
+	std::string str();
+	//Read a string and say whether it is the len bytes at src,
+	// without copying it
+	bool sameStr(const char * src, size_t len);
+	bool failed() const { return hasError; }
+	bool atEnd() const { return pos == end; }
+private:
+	ASTNode * node();
+	StmtNode * stmt();
+	ExpNode * exp();
+	LValNode * lval();
+	IDNode * id();
+	TypeNode * type();
+	FormalDeclNode * formal();
+	template <typename T>
+	T * expect(ASTNode * node);
+	template <typename T>
+	std::list<T *> * list(T * (ASTReader::*readElt)());
+	const char * pos;
+	const char * end;
+	bool hasError;
+};
+
+//An on-disk cache from program source to its parsed AST. Entries
+// are keyed by a hash of the source text and stamped with the
+// cache format and interpreter version, so a stale entry is
+// simply a miss. An entry also holds the source it was parsed
+// from, and is only used if that matches byte for byte, so a hash
+// collision (or a hand-made entry) is a miss too. Since this
+// interpreter evaluates during type analysis, only scanning and
+// parsing can be skipped on a hit; name and type analysis still
+// run on the cached tree.
+class CodeCache{
+public:
+	static const uint64_t FORMAT_VERSION = 2;
+
+	CodeCache(std::string dirIn);
+	static uint64_t hash(const char * src, size_t len);
+
+	//Returns the cached AST for the len bytes at src, or nullptr
+	// on a miss.
+	ProgramNode * lookup(const char * src, size_t len);
+	void store(const char * src, size_t len, ProgramNode * prog);
+	void printStats(std::ostream& out) const;
+private:
+	std::string pathFor(uint64_t key) const;
+	std::string dir;
+	bool dirReady;
+	size_t hits;
+	size_t misses;
+	size_t stale;
+	size_t stores;
+};
+
+}
+
+#endif
@@ -0,0 +1,56 @@
+#include "dependencies.hpp"
+
+namespace holeyc{
+
+void Dependencies::add(FnDeclNode * fn){
+	states[fn] = UNCHECKED;
+	for (SemSymbol * used : fn->getUses()){
+		users[used].insert(fn);
+	}
+}
+
+void Dependencies::remove(FnDeclNode * fn){
+	for (SemSymbol * used : fn->getUses()){
+		users[used].erase(fn);
+	}
+	states.erase(fn);
+}
+
+void Dependencies::replace(FnDeclNode * oldFn, FnDeclNode * newFn,
+	SemSymbol * sym){
+	remove(oldFn);
+	add(newFn);
+	for (FnDeclNode * user : users[sym]){
+		states[user] = UNCHECKED;
+	}
+}
+
+//Each check gets its own TypeAnalysis, which is dropped as soon as
+// the result is known. What execution needs from it is kept on the
+// nodes, so nothing about a function outlives the function itself.
+//
+//A function of the base is never checked here: its nodes are
+// shared with every other layer.
+bool Dependencies::check(FnDeclNode * fn){
+	if (base && states.count(fn) == 0){
+		auto found = base->states.find(fn);
+		if (found != base->states.end()){
+			return found->second == PASSED;
+		}
+	}
+	CheckState& state = states[fn];
+	if (state == UNCHECKED){
+		TypeAnalysis typing;
+		fn->typeAnalysis(&typing);
+		state = typing.passed() ? PASSED : FAILED;
+		numChecks++;
+	}
+	return state == PASSED;
+}
+
+void Dependencies::record(FnDeclNode * fn, bool passed){
+	states[fn] = passed ? PASSED : FAILED;
+	numChecks++;
+}
+
+}
@@ -0,0 +1,58 @@
+#ifndef HOLEYC_DEPENDENCIES_HPP
+#define HOLEYC_DEPENDENCIES_HPP
+
+#include <unordered_set>
+#include "ast.hpp"
+#include "symbol_table.hpp"
+#include "type_analysis.hpp"
+
+namespace holeyc{
+
+//Which global functions use which global symbols (the functions
+// they call and the variables they touch). Each function is type
+// checked once and the result is kept until the type of something
+// it uses changes, which happens when a function it calls is
+// redefined. A check only looks at the function's own body and at
+// the types of what it uses, so the callers of a redefined function
+// are checked again but their callers are not.
+//
+//Dependencies can be layered over a base's (a library's), which
+// must have checked all of its functions and must not change while
+// it is a base. The base's results are used as they are: nothing
+// layered over it can redefine its functions.
+class Dependencies{
+public:
+	explicit Dependencies(const Dependencies * baseIn = nullptr)
+	: base(baseIn){ }
+
+	//Start tracking fn, which has passed name analysis
+	void add(FnDeclNode * fn);
+
+	//newFn takes the place of oldFn. Their shared symbol sym may
+	// have a new type, so everything that uses it is checked again.
+	void replace(FnDeclNode * oldFn, FnDeclNode * newFn,
+		SemSymbol * sym);
+
+	//Type check fn, unless the last check is still valid. Returns
+	// whether it passed.
+	bool check(FnDeclNode * fn);
+
+	//Take the result of a check of fn made elsewhere (as when a
+	// whole program is checked at once)
+	void record(FnDeclNode * fn, bool passed);
+
+	size_t checks() const { return numChecks; }
+
+private:
+	void remove(FnDeclNode * fn);
+
+	enum CheckState { UNCHECKED, PASSED, FAILED };
+	const Dependencies * base;
+	HashMap<FnDeclNode *, CheckState> states;
+	HashMap<SemSymbol *, std::unordered_set<FnDeclNode *>> users;
+	size_t numChecks = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,19 @@
+#include "environment.hpp"
+#include "interpreter.hpp"
+
+namespace holeyc{
+
+static std::vector<std::pair<std::string, SemSymbol *>> globalsOf(
+	SymbolTable * symTab){
+	const SymbolMap * scope =
+		symTab->getGlobalScope()->getSymbols();
+	return std::vector<std::pair<std::string, SemSymbol *>>(
+		scope->begin(), scope->end());
+}
+
+Environment::Environment(Interpreter& library)
+: mySymbols(globalsOf(library.symTab)), myStrings(&library.strings),
+  myDeps(&library.dependencies), myGlobals(*library.runtime){
+}
+
+}
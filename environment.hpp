@@ -0,0 +1,42 @@
+#ifndef HOLEYC_ENVIRONMENT_HPP
+#define HOLEYC_ENVIRONMENT_HPP
+
+#include <string>
+#include "frozen_map.hpp"
+#include "runtime.hpp"
+#include "symbol_table.hpp"
+
+namespace holeyc{
+
+class Dependencies;
+class Interpreter;
+class StringPool;
+
+//Everything a library interpreter has defined, frozen so that any
+// number of sessions (see Interpreter) can start from it at once:
+// its globals, in a perfect hash map, with their types; its checked
+// functions; its string literals; and a snapshot of its global
+// variables, which each session sees copy-on-write. None of it is
+// copied into a session, and nothing a session does changes it.
+//
+//The library keeps owning its declarations, and must be left alone
+// (and alive) for as long as the environment is in use.
+class Environment{
+public:
+	explicit Environment(Interpreter& library);
+
+	const FrozenMap<SemSymbol *> * symbols() const { return &mySymbols; }
+	const StringPool * strings() const { return myStrings; }
+	const Dependencies * dependencies() const { return myDeps; }
+	const Runtime::Snapshot& globals() const { return myGlobals; }
+
+private:
+	FrozenMap<SemSymbol *> mySymbols;
+	const StringPool * myStrings;
+	const Dependencies * myDeps;
+	Runtime::Snapshot myGlobals;
+};
+
+}
+
+#endif
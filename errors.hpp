@@ -6,17 +6,14 @@
 #define CODELOC __FILE__ ":" EXPAND1(__LINE__) " - "
 #define TODO(x) throw new ToDoError(CODELOC #x);
 
+#include <algorithm>
 #include <iostream>
+#include <string>
+#include <vector>
 
-namespace holeyc{
+#include "output.hpp"
 
-class InternalError{
-public:
-	InternalError(const char * msgIn) : myMsg(msgIn){}
-	std::string msg(){ return myMsg; }
-private:
-	std::string myMsg;
-};
+namespace holeyc{
 
 class ToDoError{
 public:
@@ -26,6 +23,13 @@ private:
 	const char * myMsg;
 };
 
+//A report that has been held back, to be written later
+struct Diagnostic{
+	size_t line;
+	size_t col;
+	std::string text;
+};
+
 class Report{
 public:
 	static void fatal(
@@ -33,7 +37,13 @@ public:
 		size_t c, 
 		const char * msg
 	){
-		std::cerr << "FATAL [" << l << "," << c << "]: " 
+		if (captured()){
+			captured()->push_back({l, c,
+				"FATAL [" + std::to_string(l) + ","
+				+ std::to_string(c) + "]: " + msg});
+			return;
+		}
+		err() << "FATAL [" << l << "," << c << "]: " 
 		<< msg  << std::endl;
 	}
 
@@ -50,7 +60,7 @@ public:
 		size_t c,
 		const char * msg
 	){
-		std::cerr << "*WARNING* [" << l << "," << c << "]: " 
+		err() << "*WARNING* [" << l << "," << c << "]: " 
 		<< msg  << std::endl;
 	}
 
@@ -61,6 +71,61 @@ public:
 	){
 		warn(l,c,msg.c_str());
 	}
+
+	//Until capture(nullptr), fatal reports made on the calling
+	// thread are added to into rather than written. This is how
+	// reports from checks run in parallel are gathered up.
+	// Returns the capture it replaces, so that it can be put back.
+	static std::vector<Diagnostic> * capture(
+		std::vector<Diagnostic> * into){
+		std::vector<Diagnostic> * outer = captured();
+		captured() = into;
+		return outer;
+	}
+
+	//A report with no position, such as a syntax error
+	static void error(const std::string& msg){
+		if (captured()){
+			captured()->push_back({0, 0, msg});
+			return;
+		}
+		err() << msg << std::endl;
+	}
+
+	//Write out held-back reports in source order (or, if this
+	// thread's reports are being captured, pass them on)
+	static void flush(std::vector<Diagnostic>& diags){
+		std::stable_sort(diags.begin(), diags.end(),
+			[](const Diagnostic& a, const Diagnostic& b){
+				return a.line != b.line ? a.line < b.line
+					: a.col < b.col;
+			});
+		replay(diags);
+	}
+
+	//Write out held-back reports in the order they were made
+	static void replay(const std::vector<Diagnostic>& diags){
+		for (const Diagnostic& diag : diags){
+			if (captured()){
+				captured()->push_back(diag);
+			} else {
+				err() << diag.text << std::endl;
+			}
+		}
+	}
+
+private:
+	//Standard output is buffered, so what has been written to it so
+	// far goes first, to keep the two in order when they are merged
+	static std::ostream& err(){
+		Output::console().flush();
+		return std::cerr;
+	}
+
+	static std::vector<Diagnostic> *& captured(){
+		static thread_local std::vector<Diagnostic> * into = nullptr;
+		return into;
+	}
 };
 
 }
@@ -0,0 +1,682 @@
+#include <cerrno>
+#include <cstdlib>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "runtime.hpp"
+#include "dependencies.hpp"
+#include "input.hpp"
+#include "mem_stats.hpp"
+#include "output.hpp"
+#include "profiler.hpp"
+
+namespace holeyc{
+
+//Leave this much of the native stack for whatever runs after
+// the deepest call is refused
+static const size_t NATIVE_MARGIN = 1 << 20;
+
+//Memory is mapped directly rather than calloc'd. Fresh anonymous
+// pages are zero and untouched until used, so a large capacity
+// costs nothing up front. calloc only gets that for free while
+// malloc maps blocks this size: once one is freed, malloc raises
+// its threshold and serves the next from the heap, which calloc
+// then clears in full. That would dominate the cost of each
+// short-lived interpreter in a batch.
+static char * mapMemory(size_t capacity){
+	void * res = mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return res == MAP_FAILED ? nullptr : static_cast<char *>(res);
+}
+
+Runtime::Runtime(Dependencies * dependencies, StringPool * stringsIn,
+	Input& inIn, Output& outIn, size_t capacity)
+: deps(dependencies), strings(stringsIn), in(inIn), out(outIn),
+  nativeBase(0), nativeLimit(0),
+  mem(mapMemory(capacity)),
+  myCapacity(capacity), dataTop(RETURN_SLOT + sizeof(size_t)),
+  sp(capacity), fp(capacity), status(RUNNING), current(nullptr),
+  maxSteps(UINT64_MAX), stepsLeft(0), budgetLeft(UINT64_MAX),
+  cancel(nullptr), maxDepth(SIZE_MAX), depth(0),
+  maxMemory(SIZE_MAX){
+	size_t stack = 8 << 20;
+	struct rlimit limit;
+	if (getrlimit(RLIMIT_STACK, &limit) == 0
+		&& limit.rlim_cur != RLIM_INFINITY){
+		stack = limit.rlim_cur;
+	}
+	nativeLimit = stack > 2 * NATIVE_MARGIN ? stack - NATIVE_MARGIN
+		: stack / 2;
+	if (mem == nullptr){
+		Report::error("cannot map " + std::to_string(capacity)
+			+ " bytes of interpreter memory: " + strerror(errno));
+	}
+}
+
+Runtime::Runtime(Dependencies * dependencies, StringPool * stringsIn,
+	Input& inIn, Output& outIn, const Snapshot& base)
+: Runtime(dependencies, stringsIn, inIn, outIn, base.capacity){
+	dataTop = base.dataTop;
+	if (mem == nullptr){ return; }
+	if (base.fd >= 0){
+		void * res = mmap(mem, base.bytes, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_FIXED, base.fd, 0);
+		if (res != MAP_FAILED){ return; }
+		//The anonymous pages are still in place: fill them
+		size_t done = 0;
+		std::string why = "short read";
+		while (done < base.bytes){
+			ssize_t got = pread(base.fd, mem + done, base.bytes - done,
+				static_cast<off_t>(done));
+			if (got < 0 && errno == EINTR){ continue; }
+			if (got < 0){ why = strerror(errno); }
+			if (got <= 0){ break; }
+			done += static_cast<size_t>(got);
+		}
+		if (done == base.bytes){ return; }
+		//Without the library's globals the session can't run at all
+		Report::error("cannot read the library's globals: " + why);
+		munmap(mem, myCapacity);
+		mem = nullptr;
+		return;
+	}
+	memcpy(mem, base.copy.data(), base.bytes);
+}
+
+Runtime::Snapshot::Snapshot(const Runtime& from)
+: fd(-1), bytes(0), dataTop(from.dataTop), capacity(from.myCapacity){
+	if (from.mem == nullptr){ return; }
+	size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	bytes = (dataTop + page - 1) / page * page;
+	fd = memfd_create("holeyc-globals", MFD_CLOEXEC);
+	if (fd >= 0 && ftruncate(fd, static_cast<off_t>(bytes)) == 0){
+		size_t done = 0;
+		while (done < bytes){
+			ssize_t res = pwrite(fd, from.mem + done, bytes - done,
+				static_cast<off_t>(done));
+			if (res <= 0){ break; }
+			done += static_cast<size_t>(res);
+		}
+		if (done == bytes){ return; }
+	}
+	if (fd >= 0){
+		close(fd);
+		fd = -1;
+	}
+	copy.assign(from.mem, from.mem + bytes);
+}
+
+Runtime::Snapshot::~Snapshot(){
+	if (fd >= 0){ close(fd); }
+}
+
+Runtime::~Runtime(){
+	if (mem){ munmap(mem, myCapacity); }
+}
+
+void Runtime::setLimits(const Limits& limits){
+	maxSteps = limits.steps ? limits.steps : UINT64_MAX;
+	maxDepth = limits.callDepth ? limits.callDepth : SIZE_MAX;
+	maxMemory = limits.memory ? limits.memory : SIZE_MAX;
+}
+
+bool Runtime::runTopLevel(StmtNode * stmt){
+	if (mem == nullptr){
+		Report::fatal(stmt->line(), stmt->col(), "No interpreter memory");
+		return false;
+	}
+	char here;
+	nativeBase = reinterpret_cast<uintptr_t>(&here);
+	startBudget();
+	MemStats& memStats = MemStats::current();
+	size_t allocs = memStats.heapAllocations();
+	used.statements++;
+	current = stmt;
+	stmt->execute(this);
+	used.allocations += memStats.heapAllocations() - allocs;
+	bool res = status != FAULTED;
+	status = RUNNING;
+	sp = myCapacity;
+	fp = myCapacity;
+	current = nullptr;
+	return res;
+}
+
+void Runtime::run(std::list<StmtNode *> * body){
+	Profiler * profiler = Profiler::active();
+	StmtNode * outer = current;
+	for (auto stmt : *body){
+		current = stmt;
+		used.statements++;
+		if (profiler){ profiler->enterStmt(stmt); }
+		stmt->execute(this);
+		if (profiler){ profiler->leaveStmt(); }
+		if (status != RUNNING){ break; }
+	}
+	current = outer;
+}
+
+//The frame is claimed before the arguments are evaluated, so that
+// calls made while evaluating them push their frames below it
+void Runtime::call(FnDeclNode * fn, std::list<ExpNode *> * args){
+	size_t callerSp = sp;
+	size_t calleeFp = pushFrame(fn);
+	if (calleeFp == 0){ return; }
+
+	//A faulting argument abandons the call; invoke still pops the frame
+	auto formal = fn->getFormals()->begin();
+	for (ExpNode * arg : *args){
+		SemSymbol * sym = (*formal)->ID()->getSymbol();
+		assign(calleeFp + sym->getAddress(), sym->getDataType(), arg);
+		if (!running()){ break; }
+		++formal;
+	}
+	invoke(fn, calleeFp, callerSp);
+}
+
+//Arguments from the host have already been checked against the
+// formals, so they are stored as they are
+bool Runtime::callFromHost(FnDeclNode * fn, const std::vector<Value>& args,
+	Value& result){
+	if (mem == nullptr){
+		Report::fatal(0, 0, "No interpreter memory");
+		result = Value();
+		return false;
+	}
+	char here;
+	nativeBase = reinterpret_cast<uintptr_t>(&here);
+	startBudget();
+	MemStats& memStats = MemStats::current();
+	size_t allocs = memStats.heapAllocations();
+	size_t callerSp = sp;
+	size_t calleeFp = pushFrame(fn);
+	if (calleeFp != 0){
+		auto formal = fn->getFormals()->begin();
+		for (const Value& arg : args){
+			SemSymbol * sym = (*formal)->ID()->getSymbol();
+			storeValue(calleeFp + sym->getAddress(), arg);
+			++formal;
+		}
+		invoke(fn, calleeFp, callerSp);
+	}
+	used.allocations += memStats.heapAllocations() - allocs;
+	bool res = status != FAULTED;
+	result = res ? loadValue(RETURN_SLOT, fn->getRetTypeNode()->getType())
+		: Value();
+	status = RUNNING;
+	sp = myCapacity;
+	fp = myCapacity;
+	return res;
+}
+
+//Returns 0 (after a fault) if fn can't be called
+size_t Runtime::pushFrame(FnDeclNode * fn){
+	if (!deps->check(fn)){
+		fault("Call to a function that failed type analysis");
+		return 0;
+	}
+	step();
+	if (depth >= maxDepth){
+		fault("Call depth limit exceeded");
+		return 0;
+	}
+	size_t size = (fn->frameSize() + 7) & ~static_cast<size_t>(7);
+	if (sp - dataTop < size || nativeStackLow()){
+		fault("Stack overflow");
+		return 0;
+	}
+	if (overLimit(size)){
+		fault("Memory limit exceeded");
+		return 0;
+	}
+	depth++;
+	sp -= size;
+	used.calls++;
+	if (myCapacity - sp > used.peakFrameBytes){
+		used.peakFrameBytes = myCapacity - sp;
+	}
+	memset(mem + sp, 0, size);
+	return sp;
+}
+
+void Runtime::invoke(FnDeclNode * fn, size_t calleeFp, size_t callerSp){
+	size_t callerFp = fp;
+	storePtr(RETURN_SLOT, 0);
+	fp = calleeFp;
+	if (status == RUNNING){
+		fn->call(this);
+	}
+	if (status == RETURNING){ status = RUNNING; }
+	depth--;
+	fp = callerFp;
+	sp = callerSp;
+}
+
+//Takes the step that ran the last slice out
+void Runtime::nextSlice(){
+	if (cancel && cancel->load(std::memory_order_relaxed)){
+		fault("Interrupted");
+		return;
+	}
+	if (budgetLeft == 0){
+		fault("Step limit exceeded");
+		return;
+	}
+	uint64_t slice = budgetLeft < SLICE ? budgetLeft : SLICE;
+	budgetLeft -= slice;
+	stepsLeft = slice - 1;
+}
+
+void Runtime::fault(const char * msg){
+	if (status == FAULTED){ return; }
+	status = FAULTED;
+	if (current){
+		Report::fatal(current->line(), current->col(), msg);
+	} else {
+		Report::fatal(0, 0, msg);
+	}
+}
+
+void Runtime::badAccess(size_t addr){
+	fault(addr == 0 ? "Null pointer dereference"
+		: "Memory access out of bounds");
+}
+
+size_t Runtime::allocGlobal(size_t size){
+	size_t res = (dataTop + 7) & ~static_cast<size_t>(7);
+	if (res > sp || sp - res < size){
+		fault("Out of memory");
+		return 0;
+	}
+	if (overLimit(res - dataTop + size)){
+		fault("Memory limit exceeded");
+		return 0;
+	}
+	dataTop = res + size;
+	used.globals++;
+	return res;
+}
+
+//Every pooled string is terminated, so one that starts in the
+// pool needs no search
+const char * Runtime::findString(size_t addr) const {
+	if (!inBounds(addr, 1)){
+		if (inPool(addr, 1)){
+			return strings->at(addr - myCapacity);
+		}
+		return nullptr;
+	}
+	if (memchr(mem + addr, '\0', myCapacity - addr) == nullptr){
+		return nullptr;
+	}
+	return mem + addr;
+}
+
+const char * Runtime::loadString(size_t addr){
+	const char * res = findString(addr);
+	if (res == nullptr){
+		//Either addr is bad, or the string runs off the end
+		badAccess(inBounds(addr, 1) ? myCapacity : addr);
+	}
+	return res;
+}
+
+Value Runtime::loadValue(size_t addr, const DataType * type){
+	if (type->isInt()){
+		return Value::ofInt(loadInt(addr));
+	} else if (type->isBool()){
+		return Value::ofBool(loadBool(addr));
+	} else if (type->isChar()){
+		return Value::ofChar(loadChar(addr));
+	} else if (type->isPtr()){
+		return Value::ofPtr(loadPtr(addr));
+	}
+	return Value();
+}
+
+void Runtime::storeValue(size_t addr, const Value& val){
+	switch (val.kind){
+	case Value::INT: storeInt(addr, val.i); break;
+	case Value::BOOL: storeBool(addr, val.b); break;
+	case Value::CHAR: storeChar(addr, val.c); break;
+	case Value::PTR: storePtr(addr, val.p); break;
+	case Value::VOID: break;
+	}
+}
+
+//The value is worked out before anything is stored, so that an
+// assignment abandoned by a fault leaves its destination as it was
+void Runtime::assign(size_t addr, const DataType * type, ExpNode * src){
+	if (type->isInt()){
+		int val = src->getIntValue(this);
+		if (running()){ storeInt(addr, val); }
+	} else if (type->isBool()){
+		bool val = src->getBoolValue(this);
+		if (running()){ storeBool(addr, val); }
+	} else if (type->isChar()){
+		char val = src->getCharValue(this);
+		if (running()){ storeChar(addr, val); }
+	} else if (type->isPtr()){
+		size_t val = src->getPtrValue(this);
+		if (running()){ storePtr(addr, val); }
+	}
+}
+
+int LValNode::getIntValue(Runtime * runtime){
+	return runtime->loadInt(getAddress(runtime));
+}
+
+bool LValNode::getBoolValue(Runtime * runtime){
+	return runtime->loadBool(getAddress(runtime));
+}
+
+char LValNode::getCharValue(Runtime * runtime){
+	return runtime->loadChar(getAddress(runtime));
+}
+
+size_t LValNode::getPtrValue(Runtime * runtime){
+	return runtime->loadPtr(getAddress(runtime));
+}
+
+size_t IDNode::getAddress(Runtime * runtime){
+	if (mySymbol->isLocal()){
+		return runtime->frame() + mySymbol->getAddress();
+	}
+	return mySymbol->getAddress();
+}
+
+size_t RefNode::getPtrValue(Runtime * runtime){
+	return myID->getAddress(runtime);
+}
+
+size_t DerefNode::getAddress(Runtime * runtime){
+	return myID->getPtrValue(runtime);
+}
+
+//A negative index wraps around to a huge address, which the bounds
+// check rejects like any other
+size_t IndexNode::getAddress(Runtime * runtime){
+	size_t base = myBase->getPtrValue(runtime);
+	long offset = myOffset->getIntValue(runtime);
+	return base + static_cast<size_t>(offset) * myElemSize;
+}
+
+size_t StrLitNode::getPtrValue(Runtime * runtime){
+	return runtime->stringAddress(myOffset);
+}
+
+void CallExpNode::call(Runtime * runtime){
+	SemSymbol * sym = myID->getSymbol();
+	runtime->call(static_cast<FnSymbol *>(sym)->getDecl(), myArgs);
+}
+
+int CallExpNode::getIntValue(Runtime * runtime){
+	call(runtime);
+	return runtime->loadInt(Runtime::RETURN_SLOT);
+}
+
+bool CallExpNode::getBoolValue(Runtime * runtime){
+	call(runtime);
+	return runtime->loadBool(Runtime::RETURN_SLOT);
+}
+
+char CallExpNode::getCharValue(Runtime * runtime){
+	call(runtime);
+	return runtime->loadChar(Runtime::RETURN_SLOT);
+}
+
+size_t CallExpNode::getPtrValue(Runtime * runtime){
+	call(runtime);
+	return runtime->loadPtr(Runtime::RETURN_SLOT);
+}
+
+//Integer arithmetic wraps around on overflow, as the hardware's
+// does. It is done on unsigned values, since overflowing a signed
+// one is undefined.
+static unsigned int bits(int val){ return static_cast<unsigned int>(val); }
+static int wrapped(unsigned int val){ return static_cast<int>(val); }
+
+int PlusNode::getIntValue(Runtime * runtime){
+	int lhs = myExp1->getIntValue(runtime);
+	return wrapped(bits(lhs) + bits(myExp2->getIntValue(runtime)));
+}
+
+int MinusNode::getIntValue(Runtime * runtime){
+	int lhs = myExp1->getIntValue(runtime);
+	return wrapped(bits(lhs) - bits(myExp2->getIntValue(runtime)));
+}
+
+int TimesNode::getIntValue(Runtime * runtime){
+	int lhs = myExp1->getIntValue(runtime);
+	return wrapped(bits(lhs) * bits(myExp2->getIntValue(runtime)));
+}
+
+//INT_MIN / -1 is the one quotient that overflows, and the hardware
+// traps on it rather than wrapping, so dividing by -1 is negation
+int DivideNode::getIntValue(Runtime * runtime){
+	int lhs = myExp1->getIntValue(runtime);
+	int rhs = myExp2->getIntValue(runtime);
+	if (rhs == 0){
+		runtime->fault("Division by zero");
+		return 0;
+	}
+	if (rhs == -1){ return wrapped(0u - bits(lhs)); }
+	return lhs / rhs;
+}
+
+int NegNode::getIntValue(Runtime * runtime){
+	return wrapped(0u - bits(myExp->getIntValue(runtime)));
+}
+
+bool AndNode::getBoolValue(Runtime * runtime){
+	return myExp1->getBoolValue(runtime) && myExp2->getBoolValue(runtime);
+}
+
+bool OrNode::getBoolValue(Runtime * runtime){
+	return myExp1->getBoolValue(runtime) || myExp2->getBoolValue(runtime);
+}
+
+bool NotNode::getBoolValue(Runtime * runtime){
+	return !myExp->getBoolValue(runtime);
+}
+
+bool EqualsNode::getBoolValue(Runtime * runtime){
+	if (matchesExpTypes("int")){
+		return myExp1->getIntValue(runtime) == myExp2->getIntValue(runtime);
+	} else if (matchesExpTypes("bool")){
+		return myExp1->getBoolValue(runtime) == myExp2->getBoolValue(runtime);
+	} else if (matchesExpTypes("char")){
+		return myExp1->getCharValue(runtime) == myExp2->getCharValue(runtime);
+	}
+	return myExp1->getPtrValue(runtime) == myExp2->getPtrValue(runtime);
+}
+
+bool NotEqualsNode::getBoolValue(Runtime * runtime){
+	if (matchesExpTypes("int")){
+		return myExp1->getIntValue(runtime) != myExp2->getIntValue(runtime);
+	} else if (matchesExpTypes("bool")){
+		return myExp1->getBoolValue(runtime) != myExp2->getBoolValue(runtime);
+	} else if (matchesExpTypes("char")){
+		return myExp1->getCharValue(runtime) != myExp2->getCharValue(runtime);
+	}
+	return myExp1->getPtrValue(runtime) != myExp2->getPtrValue(runtime);
+}
+
+//Relational operators only take ints
+bool LessNode::getBoolValue(Runtime * runtime){
+	return myExp1->getIntValue(runtime) < myExp2->getIntValue(runtime);
+}
+
+bool LessEqNode::getBoolValue(Runtime * runtime){
+	return myExp1->getIntValue(runtime) <= myExp2->getIntValue(runtime);
+}
+
+bool GreaterNode::getBoolValue(Runtime * runtime){
+	return myExp1->getIntValue(runtime) > myExp2->getIntValue(runtime);
+}
+
+bool GreaterEqNode::getBoolValue(Runtime * runtime){
+	return myExp1->getIntValue(runtime) >= myExp2->getIntValue(runtime);
+}
+
+void VarDeclNode::execute(Runtime * runtime){
+	//Locals live in their function's frame. A global is given
+	// its storage the first time its declaration runs.
+	SemSymbol * sym = myID->getSymbol();
+	if (!sym->isLocal() && sym->getAddress() == 0){
+		sym->setAddress(runtime->allocGlobal(sym->getDataType()->getSize()));
+	}
+}
+
+void FnDeclNode::execute(Runtime * runtime){
+}
+
+void FnDeclNode::call(Runtime * runtime){
+	Profiler * profiler = Profiler::active();
+	if (profiler){ profiler->enterFn(this); }
+	runtime->run(myBody);
+	if (profiler){ profiler->leaveFn(); }
+}
+
+void AssignStmtNode::execute(Runtime * runtime){
+	myExp->execute(runtime);
+}
+
+void AssignExpNode::execute(Runtime * runtime){
+	runtime->assign(myDst->getAddress(runtime), myDstType, mySrc);
+}
+
+int AssignExpNode::getIntValue(Runtime * runtime){
+	execute(runtime);
+	return myDst->getIntValue(runtime);
+}
+
+bool AssignExpNode::getBoolValue(Runtime * runtime){
+	execute(runtime);
+	return myDst->getBoolValue(runtime);
+}
+
+char AssignExpNode::getCharValue(Runtime * runtime){
+	execute(runtime);
+	return myDst->getCharValue(runtime);
+}
+
+size_t AssignExpNode::getPtrValue(Runtime * runtime){
+	execute(runtime);
+	return myDst->getPtrValue(runtime);
+}
+
+static void readFromConsole(Runtime * runtime, LValNode * dst,
+	const BasicType * type){
+	Input& in = runtime->input();
+	if (type->isInt()){
+		int val;
+		if (in.readInt(val)){
+			runtime->storeInt(dst->getAddress(runtime), val);
+			return;
+		}
+	} else if (type->isBool()){
+		bool val;
+		if (in.readBool(val)){
+			runtime->storeBool(dst->getAddress(runtime), val);
+			return;
+		}
+	} else if (type->isChar()){
+		char val;
+		if (in.readChar(val)){
+			runtime->storeChar(dst->getAddress(runtime), val);
+			return;
+		}
+	}
+	Report::fatal(dst->line(), dst->col(),
+		"No " + type->getString() + " value to read");
+}
+
+void FromConsoleStmtNode::execute(Runtime * runtime){
+	readFromConsole(runtime, myDst, myDstType);
+}
+
+void ToConsoleStmtNode::execute(Runtime * runtime){
+	const DataType * childType = mySrcType;
+	Output& out = runtime->output();
+	if (childType->asPtr()){
+		//Type analysis only lets a charptr through
+		const char * str = runtime->loadString(mySrc->getPtrValue(runtime));
+		if (str){
+			out.put(str);
+			out.endLine();
+		}
+		return;
+	}
+	int intVal = 0;
+	char charVal = 0;
+	bool boolVal = false;
+	if (childType->isInt()){
+		intVal = mySrc->getIntValue(runtime);
+	} else if (childType->isChar()){
+		charVal = mySrc->getCharValue(runtime);
+	} else if (childType->isBool()){
+		boolVal = mySrc->getBoolValue(runtime);
+	}
+	//Nothing is written for a value that faulted
+	if (!runtime->running()){ return; }
+	out.put("> ");
+	if (childType->isInt()){
+		out.putInt(intVal);
+	} else if (childType->isChar()){
+		out.put(charVal);
+	} else if (childType->isBool()){
+		out.putBool(boolVal);
+	}
+	out.endLine();
+}
+
+void PostDecStmtNode::execute(Runtime * runtime){
+	size_t addr = myLVal->getAddress(runtime);
+	runtime->storeInt(addr, wrapped(bits(runtime->loadInt(addr)) - 1u));
+}
+
+void PostIncStmtNode::execute(Runtime * runtime){
+	size_t addr = myLVal->getAddress(runtime);
+	runtime->storeInt(addr, wrapped(bits(runtime->loadInt(addr)) + 1u));
+}
+
+void IfStmtNode::execute(Runtime * runtime){
+	if (myCond->getBoolValue(runtime)){
+		runtime->run(myBody);
+	}
+}
+
+//A condition that faulted reads as false, which must not pick the
+// else branch
+void IfElseStmtNode::execute(Runtime * runtime){
+	bool cond = myCond->getBoolValue(runtime);
+	if (!runtime->running()){ return; }
+	if (cond){
+		runtime->run(myBodyTrue);
+	} else {
+		runtime->run(myBodyFalse);
+	}
+}
+
+void WhileStmtNode::execute(Runtime * runtime){
+	while (myCond->getBoolValue(runtime)){
+		runtime->run(myBody);
+		runtime->step();
+		if (!runtime->running()){ return; }
+	}
+}
+
+void ReturnStmtNode::execute(Runtime * runtime){
+	if (myExp != nullptr && myType != nullptr){
+		runtime->assign(Runtime::RETURN_SLOT, myType, myExp);
+	}
+	runtime->returnFrom();
+}
+
+void CallStmtNode::execute(Runtime * runtime){
+	myCallExp->call(runtime);
+}
+
+}
@@ -0,0 +1,110 @@
+#ifndef HOLEYC_FROZEN_MAP_HPP
+#define HOLEYC_FROZEN_MAP_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace holeyc{
+
+//A map from strings that is built once and never changes, for
+// lookups shared by many threads. It is a minimal perfect hash
+// (hash and displace): one hash puts each key in a bucket, and each
+// bucket has a seed for a second hash that sends every key in it to
+// a slot of its own. A lookup is two hashes and one comparison, with
+// no chains to follow, and there are no more slots than keys.
+template <typename V>
+class FrozenMap{
+public:
+	FrozenMap(){ }
+	explicit FrozenMap(const std::vector<std::pair<std::string, V>>& entries){
+		build(entries);
+	}
+
+	//The value for key, or nullptr if it has none
+	const V * find(const std::string& key) const {
+		if (slots.empty()){ return nullptr; }
+		uint64_t bucket = hash(key, 0) % seeds.size();
+		const std::pair<std::string, V>& slot =
+			slots[hash(key, seeds[bucket]) % slots.size()];
+		return slot.first == key ? &slot.second : nullptr;
+	}
+	size_t size() const { return slots.size(); }
+
+private:
+	//FNV-1a, started from the seed, with the high bits folded in
+	// so that taking the result modulo a small size uses them
+	static uint64_t hash(const std::string& key, uint64_t seed){
+		uint64_t res = 14695981039346656037ull ^ (seed * 0x9e3779b97f4a7c15ull);
+		for (char c : key){
+			res ^= static_cast<unsigned char>(c);
+			res *= 1099511628211ull;
+		}
+		return res ^ (res >> 29);
+	}
+
+	//The biggest buckets are placed first, while most slots are
+	// free. Should a bucket run out of seeds to try, the whole
+	// placement starts again with more buckets.
+	void build(const std::vector<std::pair<std::string, V>>& entries){
+		size_t count = entries.size();
+		if (count == 0){ return; }
+		size_t numBuckets = count / 4 + 1;
+		while (!place(entries, numBuckets)){
+			numBuckets = numBuckets * 2;
+		}
+	}
+
+	bool place(const std::vector<std::pair<std::string, V>>& entries,
+		size_t numBuckets){
+		const uint64_t MAX_SEED = 1 << 16;
+		size_t count = entries.size();
+		std::vector<std::vector<size_t>> buckets(numBuckets);
+		for (size_t i = 0; i < count; i++){
+			buckets[hash(entries[i].first, 0) % numBuckets].push_back(i);
+		}
+		std::vector<size_t> order(numBuckets);
+		for (size_t i = 0; i < numBuckets; i++){ order[i] = i; }
+		std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){
+			return buckets[a].size() > buckets[b].size();
+		});
+
+		seeds.assign(numBuckets, 0);
+		std::vector<char> taken(count, 0);
+		std::vector<size_t> placed;
+		for (size_t bucket : order){
+			const std::vector<size_t>& keys = buckets[bucket];
+			if (keys.empty()){ break; }
+			uint64_t seed = 1;
+			for (; seed < MAX_SEED; seed++){
+				placed.clear();
+				for (size_t key : keys){
+					size_t slot = hash(entries[key].first, seed) % count;
+					if (taken[slot]){ break; }
+					taken[slot] = 1;
+					placed.push_back(slot);
+				}
+				if (placed.size() == keys.size()){ break; }
+				for (size_t slot : placed){ taken[slot] = 0; }
+			}
+			if (seed == MAX_SEED){ return false; }
+			seeds[bucket] = seed;
+		}
+
+		slots.assign(count, std::pair<std::string, V>());
+		for (const std::pair<std::string, V>& entry : entries){
+			uint64_t bucket = hash(entry.first, 0) % numBuckets;
+			slots[hash(entry.first, seeds[bucket]) % count] = entry;
+		}
+		return true;
+	}
+
+	std::vector<uint64_t> seeds;
+	std::vector<std::pair<std::string, V>> slots;
+};
+
+}
+
+#endif
@@ -0,0 +1,74 @@
+#include "holeyc.hpp"
+#include "errors.hpp"
+#include "interpreter.hpp"
+
+namespace holeyc{
+
+namespace {
+
+//Collects what Report says during one API call into a session's
+// errors, restoring whatever capture was there before
+class Capture{
+public:
+	Capture(std::string& errorsIn)
+	: errors(errorsIn), outer(Report::capture(&diags)){ }
+	~Capture(){
+		Report::capture(outer);
+		for (const Diagnostic& diag : diags){
+			errors += diag.text;
+			errors += '\n';
+		}
+	}
+private:
+	std::string& errors;
+	std::vector<Diagnostic> diags;
+	std::vector<Diagnostic> * outer;
+};
+
+}
+
+Session::Session()
+: in(new Input(-1)), out(new Output(&myOutput)),
+  interp(new Interpreter(*in, *out)){
+}
+
+Session::~Session(){
+	delete interp;
+	delete out;
+	delete in;
+}
+
+bool Session::evaluate(const char * src, size_t len){
+	Capture capture(myErrors);
+	return interp->evaluate(src, src + len).ok();
+}
+
+bool Session::call(const std::string& fn, const std::vector<Value>& args,
+	Value * result){
+	Capture capture(myErrors);
+	Value ignored;
+	return interp->call(fn, args, result ? *result : ignored);
+}
+
+bool Session::global(const std::string& name, Value& val){
+	return interp->global(name, val);
+}
+
+bool Session::readString(const Value& ptr, std::string& str){
+	if (ptr.kind != Value::PTR){ return false; }
+	const char * found = interp->findString(ptr.p);
+	if (found == nullptr){ return false; }
+	str = found;
+	return true;
+}
+
+void Session::setLimits(const Limits& limits){
+	interp->setLimits(limits);
+}
+
+const std::string& Session::output(){
+	out->flush();
+	return myOutput;
+}
+
+}
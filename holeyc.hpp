@@ -0,0 +1,111 @@
+#ifndef HOLEYC_HPP
+#define HOLEYC_HPP
+
+//The embedding API, for hosting HoleyC in another program. Link
+// against libholeyc.a; nothing else from the interpreter needs to
+// be included.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace holeyc{
+
+class Interpreter;
+class Input;
+class Output;
+
+//A HoleyC value passed between the host and a session. A PTR is an
+// address in the session's memory; a charptr can be turned into a
+// string with Session::readString.
+struct Value{
+	enum Kind { VOID, INT, BOOL, CHAR, PTR };
+	Kind kind;
+	union {
+		int i;
+		bool b;
+		char c;
+		size_t p;
+	};
+
+	Value() : kind(VOID), p(0){ }
+	static Value ofInt(int val){ Value v; v.kind = INT; v.i = val; return v; }
+	static Value ofBool(bool val){ Value v; v.kind = BOOL; v.b = val; return v; }
+	static Value ofChar(char val){ Value v; v.kind = CHAR; v.c = val; return v; }
+	static Value ofPtr(size_t val){ Value v; v.kind = PTR; v.p = val; return v; }
+};
+
+//Limits on what a session's statements may use, so that a runaway
+// script faults (and is reported like any other fault) rather than
+// taking its host down with it. Zero means no limit.
+struct Limits{
+	//Loop iterations and calls made by each top-level statement
+	// (or call from the host)
+	uint64_t steps = 0;
+	//Calls in progress at once
+	size_t callDepth = 0;
+	//Bytes of memory taken by global variables and call frames
+	// together
+	size_t memory = 0;
+};
+
+//An interpreter session, as in the REPL: it keeps the globals and
+// functions that have been defined, and later source can use and
+// redefine them. What TOCONSOLE writes is collected in output() and
+// errors are collected, one per line, in errors(); the host clears
+// them when it likes. FROMCONSOLE has no input to read.
+//
+//A session is not thread safe, but separate sessions can be used
+// from separate threads.
+class Session{
+public:
+	Session();
+	~Session();
+	Session(const Session&) = delete;
+	Session& operator=(const Session&) = delete;
+
+	//Evaluate each statement in src in order. A syntax error
+	// rejects all of src; otherwise a statement that fails analysis
+	// or faults while running is rejected on its own, leaving the
+	// session as it was, and the rest still run. Returns false if
+	// anything was rejected; the reasons are in errors().
+	bool evaluate(const char * src, size_t len);
+	bool evaluate(const std::string& src){
+		return evaluate(src.data(), src.size());
+	}
+
+	//Call the global function fn with args, which must match its
+	// formals in number and kind. The value it returns (VOID for a
+	// void function) is stored in result. Returns false if fn
+	// can't be called with args, or the call faults.
+	bool call(const std::string& fn, const std::vector<Value>& args,
+		Value * result = nullptr);
+
+	//The current value of a global variable. Returns false if
+	// there is no such variable (or it hasn't been declared yet).
+	bool global(const std::string& name, Value& val);
+
+	//The NUL-terminated string a charptr points to. Returns false
+	// if ptr doesn't point to one.
+	bool readString(const Value& ptr, std::string& str);
+
+	//Applies to statements evaluated and calls made from now on
+	void setLimits(const Limits& limits);
+
+	const std::string& output();
+	void clearOutput(){ myOutput.clear(); }
+	const std::string& errors() const { return myErrors; }
+	void clearErrors(){ myErrors.clear(); }
+
+private:
+	std::string myOutput;
+	std::string myErrors;
+	Input * in;
+	Output * out;
+	Interpreter * interp;
+};
+
+}
+
+#endif
@@ -46,16 +46,12 @@
   //Request tokens from our scanner member, not 
   // from a global function
   #undef yylex
-  #define yylex scanner.yylex
+  #define yylex scanner.lex
 }
 
 %union {
    bool                                  transBool;
-   holeyc::Token*                         transToken;
-   holeyc::IDToken*                       transIDToken;
-   holeyc::IntLitToken*                   transIntToken;
-   holeyc::StrToken*                      transStrToken;
-   holeyc::CharLitToken*                  transCharToken;
+   holeyc::Token                          transToken;
    holeyc::ProgramNode*                   transProgram;
    std::list<holeyc::DeclNode *> *        transDeclList;
    holeyc::DeclNode *                     transDecl;
@@ -85,7 +81,7 @@
 %token	<transToken>     BOOLPTR
 %token	<transToken>     CARAT
 %token	<transToken>     CHAR
-%token	<transCharToken> CHARLIT
+%token	<transToken>     CHARLIT
 %token	<transToken>     CHARPTR
 %token	<transToken>     COMMA
 %token	<transToken>     CROSS
@@ -96,10 +92,10 @@
 %token	<transToken>     EQUALS
 %token	<transToken>     FALSE
 %token	<transToken>     FROMCONSOLE
-%token	<transIDToken>   ID
+%token	<transToken>     ID
 %token	<transToken>     IF
 %token	<transToken>     INT
-%token	<transIntToken>  INTLITERAL
+%token	<transToken>     INTLITERAL
 %token	<transToken>     INTPTR
 %token	<transToken>     GREATER
 %token	<transToken>     GREATEREQ
@@ -119,7 +115,7 @@
 %token	<transToken>     SEMICOLON
 %token	<transToken>     SLASH
 %token	<transToken>     STAR
-%token	<transStrToken>  STRLITERAL
+%token	<transToken>     STRLITERAL
 %token	<transToken>     TOCONSOLE
 %token	<transToken>     TRUE
 %token	<transToken>     VOID
@@ -197,31 +193,31 @@ varDecl 	: type id
 
 type 		: INT
 	  	  { 
-		  $$ = new IntTypeNode($1->line(), $1->col(), false);
+		  $$ = new IntTypeNode(scanner.line($1), scanner.col($1), false);
 		  }
 		| INTPTR
 	  	  { 
-		  $$ = new IntTypeNode($1->line(), $1->col(), true);
+		  $$ = new IntTypeNode(scanner.line($1), scanner.col($1), true);
 		  }
 		| BOOL
 		  {
-		  $$ = new BoolTypeNode($1->line(), $1->col(), false);
+		  $$ = new BoolTypeNode(scanner.line($1), scanner.col($1), false);
 		  }
 		| BOOLPTR
 		  {
-		  $$ = new BoolTypeNode($1->line(), $1->col(), true);
+		  $$ = new BoolTypeNode(scanner.line($1), scanner.col($1), true);
 		  }
 		| CHAR
 		  {
-		  $$ = new CharTypeNode($1->line(), $1->col(), false);
+		  $$ = new CharTypeNode(scanner.line($1), scanner.col($1), false);
 		  }
 		| CHARPTR
 		  {
-		  $$ = new CharTypeNode($1->line(), $1->col(), true);
+		  $$ = new CharTypeNode(scanner.line($1), scanner.col($1), true);
 		  }
 		| VOID
 		  {
-		  $$ = new VoidTypeNode($1->line(), $1->col());
+		  $$ = new VoidTypeNode(scanner.line($1), scanner.col($1));
 		  }
 
 fnDecl 		: type id formals fnBody
@@ -283,40 +279,40 @@ stmt		: decl
 		  }
 		| lval DASHDASH SEMICOLON
 		  {
-		  $$ = new PostDecStmtNode($2->line(), $2->col(), $1);
+		  $$ = new PostDecStmtNode(scanner.line($2), scanner.col($2), $1);
 		  }
 		| lval CROSSCROSS SEMICOLON
 		  {
-		  $$ = new PostIncStmtNode($2->line(), $2->col(), $1);
+		  $$ = new PostIncStmtNode(scanner.line($2), scanner.col($2), $1);
 		  }
 		| FROMCONSOLE lval SEMICOLON
 		  {
-		  $$ = new FromConsoleStmtNode($1->line(), $1->col(), $2);
+		  $$ = new FromConsoleStmtNode(scanner.line($1), scanner.col($1), $2);
 		  }
 		| TOCONSOLE exp SEMICOLON
 		  {
-		  $$ = new ToConsoleStmtNode($1->line(), $1->col(), $2);
+		  $$ = new ToConsoleStmtNode(scanner.line($1), scanner.col($1), $2);
 		  }
 		| IF LPAREN exp RPAREN LCURLY stmtList RCURLY
 		  {
-		  $$ = new IfStmtNode($1->line(), $1->col(), $3, $6);
+		  $$ = new IfStmtNode(scanner.line($1), scanner.col($1), $3, $6);
 		  }
 		| IF LPAREN exp RPAREN LCURLY stmtList RCURLY ELSE LCURLY stmtList RCURLY
 		  {
-		  $$ = new IfElseStmtNode($1->line(), $1->col(), $3, 
+		  $$ = new IfElseStmtNode(scanner.line($1), scanner.col($1), $3, 
 		    $6, $10);
 		  }
 		| WHILE LPAREN exp RPAREN LCURLY stmtList RCURLY
 		  {
-		  $$ = new WhileStmtNode($1->line(), $1->col(), $3, $6);
+		  $$ = new WhileStmtNode(scanner.line($1), scanner.col($1), $3, $6);
 		  }
 		| RETURN exp SEMICOLON
 		  {
-		  $$ = new ReturnStmtNode($1->line(), $1->col(), $2);
+		  $$ = new ReturnStmtNode(scanner.line($1), scanner.col($1), $2);
 		  }
 		| RETURN SEMICOLON
 		  {
-		  $$ = new ReturnStmtNode($1->line(), $1->col(), nullptr);
+		  $$ = new ReturnStmtNode(scanner.line($1), scanner.col($1), nullptr);
 		  }
 		| callExp SEMICOLON
 		  { $$ = new CallStmtNode($1->line(), $1->col(), $1); }
@@ -325,66 +321,66 @@ exp		: assignExp
 		  { $$ = $1; } 
 		| exp DASH exp
 	  	  {
-		  $$ = new MinusNode($2->line(), $2->col(), $1, $3);
+		  $$ = new MinusNode(scanner.line($2), scanner.col($2), $1, $3);
 		  }
 		| exp CROSS exp
 	  	  {
-		  $$ = new PlusNode($2->line(), $2->col(), $1, $3);
+		  $$ = new PlusNode(scanner.line($2), scanner.col($2), $1, $3);
 		  }
 		| exp STAR exp
 	  	  {
-		  $$ = new TimesNode($2->line(), $2->col(), $1, $3);
+		  $$ = new TimesNode(scanner.line($2), scanner.col($2), $1, $3);
 		  }
 		| exp SLASH exp
 	  	  {
-		  $$ = new DivideNode($2->line(), $2->col(), $1, $3);
+		  $$ = new DivideNode(scanner.line($2), scanner.col($2), $1, $3);
 		  }
 		| exp AND exp
 	  	  {
-		  $$ = new AndNode($2->line(), $2->col(), $1, $3);
+		  $$ = new AndNode(scanner.line($2), scanner.col($2), $1, $3);
 		  }
 		| exp OR exp
 	  	  {
-		  $$ = new OrNode($2->line(), $2->col(), $1, $3);
+		  $$ = new OrNode(scanner.line($2), scanner.col($2), $1, $3);
 		  }
 		| exp EQUALS exp
 	  	  {
-		  $$ = new EqualsNode($2->line(), $2->col(), $1, $3);
+		  $$ = new EqualsNode(scanner.line($2), scanner.col($2), $1, $3);
 		  }
 		| exp NOTEQUALS exp
 	  	  {
-		  $$ = new NotEqualsNode($2->line(), $2->col(), $1, $3);
+		  $$ = new NotEqualsNode(scanner.line($2), scanner.col($2), $1, $3);
 		  }
 		| exp GREATER exp
 	  	  {
-		  $$ = new GreaterNode($2->line(), $2->col(), $1, $3);
+		  $$ = new GreaterNode(scanner.line($2), scanner.col($2), $1, $3);
 		  }
 		| exp GREATEREQ exp
 	  	  {
-		  $$ = new GreaterEqNode($2->line(), $2->col(), $1, $3);
+		  $$ = new GreaterEqNode(scanner.line($2), scanner.col($2), $1, $3);
 		  }
 		| exp LESS exp
 	  	  {
-		  $$ = new LessNode($2->line(), $2->col(), $1, $3);
+		  $$ = new LessNode(scanner.line($2), scanner.col($2), $1, $3);
 		  }
 		| exp LESSEQ exp
 	  	  {
-		  $$ = new LessEqNode($2->line(), $2->col(), $1, $3);
+		  $$ = new LessEqNode(scanner.line($2), scanner.col($2), $1, $3);
 		  }
 		| NOT exp
 	  	  {
-		  $$ = new NotNode($1->line(), $1->col(), $2);
+		  $$ = new NotNode(scanner.line($1), scanner.col($1), $2);
 		  }
 		| DASH term
 	  	  {
-		  $$ = new NegNode($1->line(), $1->col(), $2);
+		  $$ = new NegNode(scanner.line($1), scanner.col($1), $2);
 		  }
 		| term 
 	  	  { $$ = $1; }
 
 assignExp	: lval ASSIGN exp
 		  {
-		  $$ = new AssignExpNode($2->line(), $2->col(), $1, $3);
+		  $$ = new AssignExpNode(scanner.line($2), scanner.col($2), $1, $3);
 		  }
 
 callExp		: id LPAREN RPAREN
@@ -419,18 +415,18 @@ term 		: lval
 		  }
 		| NULLPTR
 		  {
-		  $$ = new NullPtrNode($1->line(), $1->col());
+		  $$ = new NullPtrNode(scanner.line($1), scanner.col($1));
 		  }
 		| INTLITERAL 
-		  { $$ = new IntLitNode($1->line(), $1->col(), $1->num()); }
+		  { $$ = new IntLitNode(scanner.line($1), scanner.col($1), $1.num()); }
 		| STRLITERAL 
-		  { $$ = new StrLitNode($1->line(), $1->col(), $1->str()); }
+		  { $$ = new StrLitNode(scanner.line($1), scanner.col($1), scanner.text($1)); }
 		| CHARLIT 
-		  { $$ = new CharLitNode($1->line(), $1->col(), $1->val()); }
+		  { $$ = new CharLitNode(scanner.line($1), scanner.col($1), $1.val()); }
 		| TRUE
-		  { $$ = new TrueNode($1->line(), $1->col()); }
+		  { $$ = new TrueNode(scanner.line($1), scanner.col($1)); }
 		| FALSE
-		  { $$ = new FalseNode($1->line(), $1->col()); }
+		  { $$ = new FalseNode(scanner.line($1), scanner.col($1)); }
 		| LPAREN exp RPAREN
 		  { $$ = $2; }
 
@@ -444,21 +440,21 @@ lval		: id
 		  }
 		| AT id
 		  {
-		  $$ = new DerefNode($1->line(), $1->col(), $2);
+		  $$ = new DerefNode(scanner.line($1), scanner.col($1), $2);
 		  }
 		| CARAT id
 		  {
-		  $$ = new RefNode($1->line(), $1->col(), $2);
+		  $$ = new RefNode(scanner.line($1), scanner.col($1), $2);
 		  }
 
 id		: ID
 		  {
-		  $$ = new IDNode($1->line(), $1->col(), $1->value()); 
+		  $$ = new IDNode(scanner.line($1), scanner.col($1), scanner.text($1)); 
 		  }
 	
 %%
 
 void holeyc::Parser::error(const std::string& msg){
-	std::cout << msg << std::endl;
-	std::cerr << "syntax error" << std::endl;
+	holeyc::Report::error(msg);
+	holeyc::Report::error("syntax error");
 }
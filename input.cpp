@@ -0,0 +1,123 @@
+#include <cerrno>
+#include <climits>
+#include <unistd.h>
+
+#include "input.hpp"
+
+namespace holeyc{
+
+Input& Input::console(){
+	static Input in(STDIN_FILENO);
+	return in;
+}
+
+Input::Input(int fdIn)
+: myPos(0), myLen(0), fd(fdIn), eof(fdIn < 0){
+}
+
+bool Input::fill(){
+	if (eof){ return false; }
+	while (true){
+		ssize_t res = read(fd, myBuf, CAPACITY);
+		if (res < 0 && errno == EINTR){ continue; }
+		if (res <= 0){
+			eof = true;
+			return false;
+		}
+		myPos = 0;
+		myLen = static_cast<size_t>(res);
+		return true;
+	}
+}
+
+void Input::skipSpace(){
+	int c = peek();
+	while (c == ' ' || c == '\t' || c == '\n' || c == '\r'){
+		myPos++;
+		c = peek();
+	}
+}
+
+bool Input::readLine(std::string& line){
+	line.clear();
+	if (peek() < 0){ return false; }
+	while (true){
+		if (myPos == myLen && !fill()){ return true; }
+		const char * start = myBuf + myPos;
+		const char * stop = myBuf + myLen;
+		for (const char * cur = start; cur != stop; cur++){
+			if (*cur == '\n'){
+				line.append(start, static_cast<size_t>(cur - start));
+				myPos += static_cast<size_t>(cur - start) + 1;
+				return true;
+			}
+		}
+		line.append(start, static_cast<size_t>(stop - start));
+		myPos = myLen;
+	}
+}
+
+//Digits are accumulated as an unsigned magnitude which saturates
+// once it passes the largest representable value, so the result is
+// clamped to the int range just as out-of-range literals are.
+bool Input::readInt(int& val){
+	skipSpace();
+	int c = peek();
+	bool negative = false;
+	if (c == '-' || c == '+'){
+		negative = (c == '-');
+		myPos++;
+		c = peek();
+	}
+	if (c < '0' || c > '9'){ return false; }
+
+	const unsigned long limit = static_cast<unsigned long>(INT_MAX) + 1;
+	unsigned long mag = 0;
+	while (c >= '0' && c <= '9'){
+		if (mag <= limit){
+			mag = mag * 10 + static_cast<unsigned long>(c - '0');
+		}
+		myPos++;
+		c = peek();
+	}
+
+	if (negative){
+		val = mag >= limit ? INT_MIN : -static_cast<int>(mag);
+	} else {
+		val = mag >= limit ? INT_MAX : static_cast<int>(mag);
+	}
+	return true;
+}
+
+//Accepts true/false as well as 1/0
+bool Input::readBool(bool& val){
+	skipSpace();
+	int c = peek();
+	if (c == '0' || c == '1'){
+		val = (c == '1');
+		myPos++;
+		return true;
+	}
+	const char * word;
+	if (c == 't'){ word = "true"; }
+	else if (c == 'f'){ word = "false"; }
+	else { return false; }
+
+	for (const char * w = word; *w != '\0'; w++){
+		if (peek() != *w){ return false; }
+		myPos++;
+	}
+	val = (word[0] == 't');
+	return true;
+}
+
+bool Input::readChar(char& val){
+	skipSpace();
+	int c = peek();
+	if (c < 0){ return false; }
+	val = static_cast<char>(c);
+	myPos++;
+	return true;
+}
+
+}
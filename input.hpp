@@ -0,0 +1,55 @@
+#ifndef HOLEYC_INPUT_HPP
+#define HOLEYC_INPUT_HPP
+
+#include <string>
+
+namespace holeyc{
+
+//A buffered reader for program input. Standard input is pulled in
+// with large read() calls and values are parsed directly out of the
+// buffer, bypassing iostream extraction. The REPL reads its lines
+// through the same reader, so FROMCONSOLE and the REPL never
+// disagree about what has already been consumed.
+class Input{
+public:
+	//The shared reader for standard input
+	static Input& console();
+
+	//A negative fd gives an input with nothing in it
+	Input(int fdIn);
+
+	//Read up to the next newline (which is consumed but not
+	// stored). Returns false only at end of input.
+	bool readLine(std::string& line);
+
+	//Whether more input has already arrived, so the next read
+	// will not wait for it (as with the rest of a pasted block)
+	bool hasBuffered() const { return myPos < myLen; }
+
+	//Each of the following skips leading whitespace and then
+	// parses one value. They return false, leaving val untouched,
+	// if the input is exhausted or isn't a value of the right form.
+	bool readInt(int& val);
+	bool readBool(bool& val);
+	bool readChar(char& val);
+private:
+	//Returns the next byte without consuming it, or -1 at the
+	// end of input
+	int peek(){
+		if (myPos == myLen && !fill()){ return -1; }
+		return static_cast<unsigned char>(myBuf[myPos]);
+	}
+	bool fill();
+	void skipSpace();
+
+	static const size_t CAPACITY = 1 << 16;
+	char myBuf[CAPACITY];
+	size_t myPos;
+	size_t myLen;
+	int fd;
+	bool eof;
+};
+
+}
+
+#endif
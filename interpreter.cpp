@@ -0,0 +1,445 @@
+#include <cstring>
+#include <vector>
+
+#include "interpreter.hpp"
+#include "mem_stats.hpp"
+#include "perf_counters.hpp"
+#include "profiler.hpp"
+#include "repl_chunk.hpp"
+#include "trace.hpp"
+#include "type_analysis.hpp"
+
+namespace holeyc{
+
+static std::string traceLabel(StmtNode * stmt){
+	return Tracer::active() ? stmt->nodeKind() + " " + stmt->pos() : "";
+}
+
+//Each entry point counts what it allocates and frees against the
+// session (see MemStats)
+Interpreter::Interpreter(Input& inIn, Output& outIn,
+	const Environment * library)
+: strings(library ? library->strings() : nullptr),
+  dependencies(library ? library->dependencies() : nullptr){
+	MemStats::Scope session(&stats);
+	ast = new ProgramNode(new std::list<StmtNode *>());
+	symTab = new SymbolTable(&strings, library ? library->symbols() : nullptr);
+	runtime = library
+		? new Runtime(&dependencies, &strings, inIn, outIn, library->globals())
+		: new Runtime(&dependencies, &strings, inIn, outIn);
+	symTab->enterScope();
+}
+
+Interpreter::~Interpreter(){
+	MemStats::Scope session(&stats);
+	delete runtime;
+	delete ast;
+	delete symTab;
+}
+
+ProgramNode * Interpreter::parse(Scanner& scanner){
+	ProgramNode * root = nullptr;
+
+	Tracer * tracer = Tracer::active();
+	uint64_t parseStart = tracer ? tracer->now() : 0;
+	scanner.setTimed(tracer != nullptr);
+	Parser parser(scanner, &root);
+
+	//The scanner runs interleaved with the parser too. To count them
+	// apart, the source is first scanned on its own, and that pass's
+	// counts are taken out of the parse's.
+	PerfCounters * counters = PerfCounters::active();
+	if (counters){
+		CounterSpan span(PerfCounters::SCAN);
+		Scanner pass(scanner.begin(), scanner.limit());
+		pass.setQuiet(true);
+		Parser::semantic_type lval;
+		while (pass.lex(&lval) != TokenKind::END){ }
+	}
+	int errCode;
+	{
+		CounterSpan span(PerfCounters::PARSE);
+		errCode = parser.parse();
+	}
+	if (counters){ counters->deduct(PerfCounters::SCAN, PerfCounters::PARSE); }
+	if (tracer){
+		//The scanner runs interleaved with the parser, so its time
+		// is reported as a single span at the start of the parse
+		uint64_t parseNs = tracer->now() - parseStart;
+		tracer->span("scan", parseStart, scanner.scanNs(),
+			"\"tokens\":" + std::to_string(scanner.tokens()));
+		tracer->span("parse", parseStart, parseNs);
+	}
+	if (errCode != 0){
+		return nullptr;
+	}
+	return root;
+}
+
+bool Interpreter::runProgram(ProgramNode * prog, size_t jobs){
+	MemStats::Scope session(&stats);
+	std::list<StmtNode *> * globals = prog->getGlobals();
+	std::vector<StmtNode *> stmts(globals->begin(), globals->end());
+	globals->clear();
+	delete prog;
+	{
+		CounterSpan counted(PerfCounters::ANALYZE);
+		for (size_t i = 0; i < stmts.size(); i++){
+			//A rejected statement is deleted; the rest are never run
+			if (!declareGlobal(stmts[i], false)){
+				for (size_t j = i + 1; j < stmts.size(); j++){
+					delete stmts[j];
+				}
+				return false;
+			}
+		}
+	}
+	std::vector<char> passed;
+	{
+		CounterSpan counted(PerfCounters::ANALYZE);
+		TraceSpan span("typeAnalysis");
+		span.arg("threads", static_cast<uint64_t>(jobs));
+		TypeAnalysis::checkAll(stmts, passed, jobs);
+	}
+	bool res = true;
+	for (size_t i = 0; i < stmts.size(); i++){
+		if (!passed[i]){ res = false; }
+		if (stmts[i]->isFnDecl()){
+			dependencies.record(static_cast<FnDeclNode *>(stmts[i]),
+				passed[i]);
+		}
+	}
+	CounterSpan counted(PerfCounters::EXECUTE);
+	for (size_t i = 0; i < stmts.size(); i++){
+		if (stmts[i]->isFnDecl()){ continue; }
+		if (passed[i]){
+			if (!runGlobal(stmts[i])){ res = false; }
+		} else if (!stmts[i]->isDecl() && !Profiler::active()){
+			delete stmts[i];
+		}
+	}
+	return res;
+}
+
+Status Interpreter::evaluate(const char * begin, const char * end){
+	MemStats::Scope session(&stats);
+	TraceSpan span("input");
+	span.arg("source", "repl");
+	return evaluateSource(begin, end, true);
+}
+
+//Just past the end of each complete top-level statement in REPL
+// input, as the REPL itself tells where they end, and then end
+static std::vector<const char *> statementEnds(const char * begin,
+	const char * end){
+	std::vector<const char *> res;
+	ReplChunk chunk;
+	bool pending = false;
+	const char * pos = begin;
+	while (pos < end){
+		const char * nl = static_cast<const char *>(
+			memchr(pos, '\n', static_cast<size_t>(end - pos)));
+		const char * next = nl ? nl + 1 : end;
+		std::string line(pos, nl ? nl : end);
+		chunk.scan(line);
+		if (line.find_first_not_of(" \t\r") != std::string::npos){
+			pending = true;
+		}
+		if (pending && chunk.complete()){
+			res.push_back(next);
+			pending = false;
+		}
+		pos = next;
+	}
+	if (res.empty() || res.back() != end){ res.push_back(end); }
+	return res;
+}
+
+//Input is parsed in one pass, since it usually parses. When it
+// doesn't, and it holds more than one statement, what that pass
+// reported is dropped and each statement is evaluated on its own, so
+// that only the bad one is rejected.
+Status Interpreter::evaluateSource(const char * begin, const char * end,
+	bool split){
+	std::vector<Diagnostic> diags;
+	auto outer = Report::capture(&diags);
+	//The input is scanned and parsed in place
+	Scanner scanner(begin, end);
+	ProgramNode * temp = parse(scanner);
+	Report::capture(outer);
+	Status res;
+	if (temp == nullptr && split){
+		std::vector<const char *> ends = statementEnds(begin, end);
+		if (ends.size() > 1){
+			const char * start = begin;
+			for (const char * stop : ends){
+				Status stmtRes = evaluateSource(start, stop, false);
+				if (res.ok()){ res = stmtRes; }
+				start = stop;
+			}
+			return res;
+		}
+	}
+	Report::replay(diags);
+	if (temp == nullptr){
+		res.code = Status::SYNTAX;
+		return res;
+	}
+	std::list<StmtNode *> * globals = temp->getGlobals();
+	while (!globals->empty()){
+		StmtNode * stmt = globals->front();
+		globals->pop_front();
+		Status stmtRes = evaluateGlobal(stmt, true);
+		if (res.ok()){ res = stmtRes; }
+	}
+	delete temp;
+	return res;
+}
+
+//A statement that fails type analysis is reported and not run.
+// The session owns stmt from here on: declarations are kept,
+// anything else is deleted once it has run (unless the profiler
+// needs it).
+Status Interpreter::evaluateGlobal(StmtNode * stmt, bool allowRedefine){
+	Status res;
+	res.line = stmt->line();
+	res.col = stmt->col();
+	if (!declareGlobal(stmt, allowRedefine)){
+		res.code = Status::NAME;
+		return res;
+	}
+	{
+		TraceSpan span("typeAnalysis");
+		span.arg("stmt", traceLabel(stmt));
+		if (stmt->isFnDecl()){
+			if (!dependencies.check(static_cast<FnDeclNode *>(stmt))){
+				res.code = Status::TYPE;
+			}
+			return res;
+		}
+		TypeAnalysis typing;
+		stmt->typeAnalysis(&typing);
+		if (!typing.passed()){
+			if (!stmt->isDecl() && !Profiler::active()){ delete stmt; }
+			res.code = Status::TYPE;
+			return res;
+		}
+	}
+	if (!runGlobal(stmt)){ res.code = Status::FAULT; }
+	return res;
+}
+
+//Take ownership of stmt, name analyze it and, if it is a function,
+// start tracking its dependencies.
+//
+//With allowRedefine (the REPL), a function that is already defined
+// may be entered again. The new declaration takes the old one's
+// place and only it is name analyzed. It keeps the old symbol, so
+// callers stay bound to it; they are type checked again against the
+// new signature the next time they are called.
+//
+//A statement that fails name analysis is taken back out of the
+// session, undoing whatever it changed, and deleted.
+bool Interpreter::declareGlobal(StmtNode * stmt, bool allowRedefine){
+	SemSymbol * oldSym = nullptr;
+	if (allowRedefine && stmt->isFnDecl()){
+		FnDeclNode * fn = static_cast<FnDeclNode *>(stmt);
+		oldSym = symTab->getCurrentScope()->lookup(fn->ID()->getName());
+		if (oldSym != nullptr && oldSym->getKind() != FN){
+			oldSym = nullptr;
+		}
+	}
+	FnDeclNode * oldFn = nullptr;
+	DataType * oldType = nullptr;
+	if (oldSym){
+		auto found = fnIndex.find(oldSym->getName());
+		oldFn = static_cast<FnDeclNode *>(*found->second);
+		oldType = oldSym->getDataType();
+		*found->second = stmt;
+	} else if (stmt->isDecl()){
+		ast->addGlobal(stmt);
+		if (stmt->isFnDecl()){
+			std::string name = static_cast<FnDeclNode *>(stmt)->ID()->getName();
+			fnIndex[name] = std::prev(ast->getGlobals()->end());
+		}
+	}
+	{
+		TraceSpan span("nameAnalysis");
+		span.arg("stmt", traceLabel(stmt));
+		bool named = oldSym
+			? static_cast<FnDeclNode *>(stmt)->redefine(symTab, oldSym)
+			: stmt->nameAnalysis(symTab);
+		if (!named){
+			if (oldSym){
+				*fnIndex.find(oldSym->getName())->second = oldFn;
+				oldSym->setDataType(oldType);
+				static_cast<FnSymbol *>(oldSym)->setDecl(oldFn);
+			} else if (stmt->isDecl()){
+				ast->getGlobals()->pop_back();
+				if (stmt->isFnDecl()){
+					forget(static_cast<FnDeclNode *>(stmt));
+				}
+			}
+			delete stmt;
+			return false;
+		}
+	}
+	if (stmt->isFnDecl()){
+		FnDeclNode * fn = static_cast<FnDeclNode *>(stmt);
+		if (oldFn){
+			dependencies.replace(oldFn, fn, oldSym);
+			if (!Profiler::active()){ delete oldFn; }
+		} else {
+			dependencies.add(fn);
+		}
+	}
+	return true;
+}
+
+//Undo the declaration of a new function that failed name analysis.
+// Its symbol goes too, if it got as far as adding one. Nothing
+// else can be using it yet.
+void Interpreter::forget(FnDeclNode * fn){
+	std::string name = fn->ID()->getName();
+	fnIndex.erase(name);
+	ScopeTable * globals = symTab->getGlobalScope();
+	SemSymbol * sym = globals->lookup(name);
+	if (sym != nullptr && sym->getKind() == FN
+		&& static_cast<FnSymbol *>(sym)->getDecl() == fn){
+		globals->remove(name);
+	}
+}
+
+//Run stmt, which has passed type analysis, then free it unless it
+// is a declaration (or the profiler needs it). Returns false if it
+// faulted.
+bool Interpreter::runGlobal(StmtNode * stmt){
+	Profiler * profiler = Profiler::active();
+	if (profiler){ profiler->enterStmt(stmt); }
+	bool res;
+	{
+		TraceSpan span("execute");
+		span.arg("stmt", traceLabel(stmt));
+		res = runtime->runTopLevel(stmt);
+	}
+	if (profiler){
+		profiler->leaveStmt();
+	} else if (!stmt->isDecl()){
+		delete stmt;
+	}
+	return res;
+}
+
+//Whether a host value can be passed as a formal of the given type
+static bool matches(const Value& val, const DataType * type){
+	switch (val.kind){
+	case Value::INT: return type->isInt();
+	case Value::BOOL: return type->isBool();
+	case Value::CHAR: return type->isChar();
+	case Value::PTR: return type->isPtr();
+	case Value::VOID: return false;
+	}
+	return false;
+}
+
+bool Interpreter::call(const std::string& name,
+	const std::vector<Value>& args, Value& result){
+	MemStats::Scope session(&stats);
+	SemSymbol * sym = symTab->find(name);
+	if (sym == nullptr || sym->getKind() != FN){
+		Report::error("No function named " + name);
+		return false;
+	}
+	const FnType * type = sym->getDataType()->asFn();
+	const std::list<const DataType *> * formals = type->getFormalTypes();
+	bool valid = formals->size() == args.size();
+	auto formal = formals->begin();
+	for (size_t i = 0; valid && i < args.size(); i++, ++formal){
+		valid = matches(args[i], *formal);
+	}
+	if (!valid){
+		Report::error("Arguments do not match the formals of " + name
+			+ " (" + type->getString() + ")");
+		return false;
+	}
+	FnDeclNode * fn = static_cast<FnSymbol *>(sym)->getDecl();
+	return runtime->callFromHost(fn, args, result);
+}
+
+//A global's storage is set aside when its declaration runs
+bool Interpreter::global(const std::string& name, Value& val){
+	SemSymbol * sym = symTab->find(name);
+	if (sym == nullptr || sym->getKind() != VAR || sym->getAddress() == 0
+		|| !runtime->hasMemory()){
+		return false;
+	}
+	val = runtime->loadValue(sym->getAddress(), sym->getDataType());
+	return true;
+}
+
+//Right-aligned in a column of width characters
+static std::string column(size_t val, size_t width){
+	std::string res = std::to_string(val);
+	return res.size() < width ? std::string(width - res.size(), ' ') + res
+		: res;
+}
+
+static void statsRow(Output& to, const std::string& name, size_t bytes,
+	size_t live, size_t allocations){
+	std::string label = name.size() < 12
+		? name + std::string(12 - name.size(), ' ') : name;
+	to.put(">   " + label + column(bytes, 12) + column(live, 10)
+		+ column(allocations, 13));
+	to.endLine();
+}
+
+//Node bytes count the nodes themselves, not the strings and child
+// lists they point to. The counts are this session's own (see
+// MemStats), apart from peak RSS, which is the process's.
+void Interpreter::printStats(Output& to){
+	to.put("> retained: " + std::to_string(ast->getGlobals()->size())
+		+ " declarations (" + std::to_string(fnIndex.size())
+		+ " functions), "
+		+ std::to_string(stats.liveCount(MemStats::AST))
+		+ " AST nodes, "
+		+ std::to_string(stats.liveBytes(MemStats::AST)) + " bytes, "
+		+ std::to_string(strings.count()) + " string literals ("
+		+ std::to_string(strings.size()) + " bytes)");
+	to.endLine();
+
+	to.put(">   subsystem     live bytes  live objs  allocations");
+	to.endLine();
+	for (int i = 0; i < MemStats::NUM_SUBSYSTEMS; i++){
+		MemStats::Subsystem sys = static_cast<MemStats::Subsystem>(i);
+		statsRow(to, MemStats::name(sys), stats.liveBytes(sys),
+			stats.liveCount(sys), stats.allocations(sys));
+	}
+	const Runtime::Usage& used = runtime->usage();
+	statsRow(to, "runtime", runtime->globalBytes(), used.globals,
+		used.globals + used.calls);
+	if (MemStats::heapCounted()){
+		//Heap blocks are counted as they are made, not as they are
+		// freed, so nothing is known to be live
+		to.put(">   heap        " + std::string(11, ' ') + "-"
+			+ std::string(9, ' ') + "-" + column(stats.heapAllocations(), 13));
+		to.endLine();
+	}
+
+	std::string line = "> peak RSS: " + std::to_string(MemStats::peakRss())
+		+ " KiB, deepest stack: " + std::to_string(used.peakFrameBytes)
+		+ " bytes, statements run: " + std::to_string(used.statements);
+	if (MemStats::heapCounted()){
+		//Hundredths, without going through floating point formatting
+		uint64_t per = used.statements == 0 ? 0
+			: used.allocations * 100 / used.statements;
+		std::string frac = std::to_string(per % 100);
+		line += ", heap allocated: " + std::to_string(stats.heapBytes())
+			+ " bytes, heap allocations per statement: "
+			+ std::to_string(per / 100) + "."
+			+ (frac.size() < 2 ? "0" : "") + frac;
+	}
+	to.put(line);
+	to.endLine();
+}
+
+}
@@ -0,0 +1,117 @@
+#ifndef HOLEYC_INTERPRETER_HPP
+#define HOLEYC_INTERPRETER_HPP
+
+#include <list>
+#include <string>
+#include "ast.hpp"
+#include "dependencies.hpp"
+#include "environment.hpp"
+#include "input.hpp"
+#include "mem_stats.hpp"
+#include "output.hpp"
+#include "runtime.hpp"
+#include "scanner.hpp"
+#include "string_pool.hpp"
+#include "symbol_table.hpp"
+
+namespace holeyc{
+
+//How a piece of input fared. Errors are reported through Report as
+// they are found; this only says whether anything was rejected, at
+// which stage, and where the (first) rejected statement starts. It
+// is a plain value, so passing it back costs nothing.
+struct Status{
+	enum Code { OK, SYNTAX, NAME, TYPE, FAULT };
+	Code code = OK;
+	size_t line = 0;
+	size_t col = 0;
+
+	bool ok() const { return code == OK; }
+};
+
+//One HoleyC session: the declarations it keeps, its symbol table
+// and string pool, and the memory its statements run in. Nothing
+// is shared between interpreters except types, which never change
+// once they are made, so separate interpreters can run on separate
+// threads. Errors go through Report, which each thread can capture
+// on its own.
+//
+//An interpreter can also be started from a library's Environment,
+// whose globals and functions it can use but not change. Its own
+// copy of the library's global variables is copy-on-write, and it
+// may define names of its own that hide the library's (the
+// library's functions still use their own). Any number of
+// interpreters, on any threads, can share an environment.
+class Interpreter{
+public:
+	//FROMCONSOLE reads from in and TOCONSOLE writes to out
+	Interpreter(Input& inIn, Output& outIn,
+		const Environment * library = nullptr);
+	~Interpreter();
+
+	//Scan and parse a whole program. Returns nullptr (having
+	// reported why) on a syntax error.
+	static ProgramNode * parse(Scanner& scanner);
+
+	//Run a program, taking over its statements (prog itself is
+	// deleted). The whole program is name analyzed first. Then its
+	// statements are type checked together on up to jobs threads,
+	// and the ones that pass are run in order. Returns false if
+	// the program fails name analysis (and then nothing is run), or
+	// if any of it fails type analysis or faults.
+	bool runProgram(ProgramNode * prog, size_t jobs);
+
+	//Parse REPL input and evaluate each statement in it in order.
+	// A function may redefine an earlier one. A statement that fails
+	// to parse or analyze, or faults, is rejected on its own, leaving
+	// the session as it was before the statement was entered, and the
+	// rest still run: the outcome is the same whether the statements
+	// arrive together or one at a time.
+	Status evaluate(const char * begin, const char * end);
+
+	void setLimits(const Limits& limits){ runtime->setLimits(limits); }
+	//Stop what is running, and anything run later, once *flag is set
+	void setCancel(const std::atomic<bool> * flag){
+		runtime->setCancel(flag);
+	}
+
+	//Report what the session is holding on to
+	void printStats(Output& to);
+	//What the session has allocated. A program parsed for it (see
+	// parse) should be parsed in a MemStats::Scope of these, so its
+	// nodes are counted against the session that frees them.
+	MemStats& memStats(){ return stats; }
+
+	//For the embedding API (see Session in holeyc.hpp)
+	bool call(const std::string& name, const std::vector<Value>& args,
+		Value& result);
+	bool global(const std::string& name, Value& val);
+	const char * findString(size_t addr) const {
+		return runtime->findString(addr);
+	}
+
+private:
+	friend class Environment;
+
+	Status evaluateSource(const char * begin, const char * end, bool split);
+	Status evaluateGlobal(StmtNode * stmt, bool allowRedefine);
+	bool declareGlobal(StmtNode * stmt, bool allowRedefine);
+	bool runGlobal(StmtNode * stmt);
+	void forget(FnDeclNode * fn);
+
+	MemStats stats;
+	//The declarations the session keeps: each global variable and
+	// the current definition of each function, in the order they
+	// were entered. Functions are also indexed by name. Other
+	// statements are freed once they have run.
+	ProgramNode * ast;
+	HashMap<std::string, std::list<StmtNode *>::iterator> fnIndex;
+	StringPool strings;
+	SymbolTable * symTab;
+	Dependencies dependencies;
+	Runtime * runtime;
+};
+
+}
+
+#endif
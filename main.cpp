@@ -1,141 +1,382 @@
+#include <chrono>
+#include <csignal>
 #include <fstream>
+#include <sstream>
+#include <iterator>
+#include <new>
+#include <stdlib.h>
 #include <string.h>
 #include <iostream>
+#include <thread>
+#include <unistd.h>
+#include <vector>
 
 // #include "errors.hpp"
 #include "scanner.hpp"
 #include "ast.hpp"
-#include "name_analysis.hpp"
-#include "type_analysis.hpp"
+#include "batch.hpp"
+#include "code_cache.hpp"
+#include "environment.hpp"
+#include "input.hpp"
+#include "interpreter.hpp"
+#include "mem_stats.hpp"
+#include "output.hpp"
+#include "perf_counters.hpp"
+#include "profiler.hpp"
+#include "repl_chunk.hpp"
+#include "server.hpp"
+#include "source_file.hpp"
+#include "trace.hpp"
 
 using namespace holeyc;
 using namespace std;
 
-void evaluateCallStmt(StmtNode * callStmt);
-static holeyc::ProgramNode *syntacticAnalysis(std::ifstream *input);
-static holeyc::NameAnalysis *doNameAnalysis(std::ifstream *input);
-static holeyc::TypeAnalysis * doTypeAnalysis(std::ifstream *input);
+static int runScript(Interpreter& interp, const char * path,
+  CodeCache * cache, size_t jobs);
+static int runRepl(Interpreter& interp);
+static int runBatchMode(vector<string> paths, size_t jobs,
+  const Limits& limits);
+static int runServer(const char * socketPath, const vector<string>& preload,
+  size_t jobs, const Limits& limits);
+static bool writeProfile(const char * path);
 
-holeyc::ProgramNode * ast = new holeyc::ProgramNode(new std::list<StmtNode *>()); // this is the ast we will be adding globals to.
-holeyc::NameAnalysis *nameAnalysis = new holeyc::NameAnalysis;
-TypeAnalysis *typeAnalysis = new TypeAnalysis();
-SymbolTable *symTab = new SymbolTable();
+// With --stats, every heap allocation is counted against the session
+// that made it, so that :stats and --stats can report how much
+// running a statement allocates (see MemStats). The array forms come
+// back through these. Without it, they only pass through to malloc.
+void * operator new(size_t size){
+  void * res = malloc(size > 0 ? size : 1);
+  if (res == nullptr){
+    throw std::bad_alloc();
+  }
+  if (MemStats::countingHeap()){
+    MemStats::heapAllocated(size);
+  }
+  return res;
+}
 
-int main(){
-  holeyc::ProgramNode * temp = nullptr;
-  StmtNode * stmt = nullptr;
-  ast->nameAnalysis(symTab);
-  symTab->enterScope();
+void operator delete(void * ptr) noexcept{
+  free(ptr);
+}
 
-  cout << "> Welcome to dragoninterp! Enter HoleyC code to be interpreted...\n";
-  string input;
-  while(true){
-    cin.clear();
-    cout << "> ";
-    getline(cin, input);
-    if(input == "quit"){
-      symTab->leaveScope();
-      return 0;
-    }
-    if(input.find("{") != string::npos){
-      if ((input.find("if") != string::npos || input.find("while") != string::npos) && (input.find("(") != string::npos && input.find(")") != string::npos)){
-        cout << "ERROR: Cannot perform conditionals outside of a function.\n";
+void operator delete(void * ptr, size_t size) noexcept{
+  free(ptr);
+}
+
+static void usage(){
+  cerr << "usage: dragoninterp [--cache-dir DIR] [--cache-stats] [--stats]\n"
+       << "                   [--profile FILE] [--trace FILE] [--counters OUT]\n"
+       << "                   [--jobs N] [FILE]\n"
+       << "       dragoninterp --batch [--jobs N] [FILE...]\n"
+       << "       dragoninterp --serve SOCKET [--preload FILE]... [--stats]\n"
+       << "                   [--jobs N]\n"
+       << "  With no FILE, start an interactive session. Each form also\n"
+       << "  takes limits, which make a statement that goes over them fault:\n"
+       << "  --max-steps N    loop iterations and calls per top-level statement\n"
+       << "  --max-depth N    calls in progress at once\n"
+       << "  --max-memory N   bytes of global variables and call frames\n"
+       << "  --cache-dir DIR  cache parsed programs in DIR (also\n"
+       << "                   taken from $DRAGONINTERP_CACHE)\n"
+       << "  --cache-stats    report cache hits and misses on exit\n"
+       << "  --stats          count heap allocations too, for :stats, and\n"
+       << "                   report memory use, by subsystem, on exit\n"
+       << "  --profile FILE   count and time every function and statement;\n"
+       << "                   print a flat profile on exit and write\n"
+       << "                   collapsed stacks for flamegraphs to FILE\n"
+       << "  --trace FILE     write the time spent in each interpreter\n"
+       << "                   phase to FILE as Chrome trace events\n"
+       << "  --counters OUT   count cycles, instructions, branch misses\n"
+       << "                   and cache misses in each phase of running\n"
+       << "                   FILE, and write them to OUT\n"
+       << "  --jobs N         type check FILE on N threads (default: one\n"
+       << "                   per core)\n"
+       << "  --batch          run every FILE (or, if none are given, each\n"
+       << "                   one named on a line of standard input) in\n"
+       << "                   its own interpreter, N at a time, and print\n"
+       << "                   the output of each in turn\n"
+       << "  --serve SOCKET   serve REPL sessions on a Unix domain socket,\n"
+       << "                   running them on N threads\n"
+       << "  --preload FILE   run FILE once, before serving; every session\n"
+       << "                   starts with what it defines\n";
+}
+
+int main(int argc, char * argv[]){
+  const char * script = nullptr;
+  const char * cacheDir = getenv("DRAGONINTERP_CACHE");
+  bool cacheStats = false;
+  bool memStats = false;
+  const char * profileOut = nullptr;
+  size_t jobs = std::thread::hardware_concurrency();
+  bool batch = false;
+  vector<string> batchPaths;
+  const char * socketPath = nullptr;
+  vector<string> preload;
+  Limits limits;
+  for (int i = 1; i < argc; i++){
+    if (strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc){
+      cacheDir = argv[++i];
+    } else if (strcmp(argv[i], "--cache-stats") == 0){
+      cacheStats = true;
+    } else if (strcmp(argv[i], "--stats") == 0){
+      memStats = true;
+    } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc){
+      profileOut = argv[++i];
+      Profiler::enable();
+    } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc){
+      if (!Tracer::open(argv[++i])){
+        cerr << "dragoninterp: cannot write trace to " << argv[i] << "\n";
         return 1;
       }
-      string temp = input + "\n";
-      size_t brace_equality = 1;
-      string tabs = "";
-      while(brace_equality != 0) {
-        cin.clear();
-        cout << ". " << string(brace_equality,'\t');
-        getline(cin, input);
-        temp = temp + input + "\n";
-        if (input.find("{") != string::npos) { brace_equality++; }
-        if (input.find("}") != string::npos) { brace_equality--; }
+    } else if (strcmp(argv[i], "--counters") == 0 && i + 1 < argc){
+      if (!PerfCounters::open(argv[++i])){
+        cerr << "dragoninterp: cannot write counters to " << argv[i] << "\n";
+        return 1;
       }
-      input = temp;
-    }
-    ofstream outStream("string.txt");
-    outStream << input;
-    outStream.close();
-    ifstream myFile("string.txt");
-    temp = syntacticAnalysis(&myFile);
-    if(temp == nullptr){ cout << "error!"; return 1; }
-    stmt = temp->getGlobals()->front(); // expect the input to be converted into a StmtNode found at the front of the globals list
-    ast->addGlobal(stmt);
-    StmtNode * current_stmt = ast->getGlobals()->back();
-    if(!current_stmt->nameAnalysis(symTab)){ // perform nameAnalysis on latest addition. Quit if failure.
+    } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc){
+      jobs = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--max-steps") == 0 && i + 1 < argc){
+      limits.steps = strtoull(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--max-depth") == 0 && i + 1 < argc){
+      limits.callDepth = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--max-memory") == 0 && i + 1 < argc){
+      limits.memory = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--batch") == 0){
+      batch = true;
+    } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc){
+      socketPath = argv[++i];
+    } else if (strcmp(argv[i], "--preload") == 0 && i + 1 < argc){
+      preload.push_back(argv[++i]);
+    } else if (batch && argv[i][0] != '-'){
+      batchPaths.push_back(argv[i]);
+    } else if (argv[i][0] == '-' || script != nullptr){
+      usage();
       return 1;
     } else {
-      if (current_stmt->isCallStmt()){
-        current_stmt->typeAnalysis(typeAnalysis);
-        evaluateCallStmt(current_stmt); // deal with callStmts differently.
-      } else if (current_stmt->isFnDecl()) {
-      } else {
-        current_stmt->typeAnalysis(typeAnalysis); // perform typeAnalysis on latest addition.
-      }
+      script = argv[i];
     }
   }
-  symTab->leaveScope();
-  return 0;
+  // A batch never reports it
+  if (memStats && !batch){
+    MemStats::startHeapCounting();
+  }
+  if (batch){
+    // Profiling, tracing and counting follow a single interpreter
+    if (script != nullptr || Profiler::active() || Tracer::active()
+      || PerfCounters::active()){
+      usage();
+      return 1;
+    }
+    return runBatchMode(batchPaths, jobs, limits);
+  }
+  if (socketPath != nullptr || !preload.empty()){
+    if (socketPath == nullptr || batch || script != nullptr
+      || Profiler::active() || Tracer::active() || PerfCounters::active()){
+      usage();
+      return 1;
+    }
+    return runServer(socketPath, preload, jobs, limits);
+  }
+
+  // Counting is by phase of running a program
+  if (script == nullptr && PerfCounters::active()){
+    usage();
+    return 1;
+  }
+  Interpreter interp(Input::console(), Output::console());
+  interp.setLimits(limits);
+  int res;
+  if (script == nullptr){
+    res = runRepl(interp);
+  } else {
+    CodeCache * cache = nullptr;
+    if (cacheDir != nullptr && cacheDir[0] != '\0'){
+      cache = new CodeCache(cacheDir);
+    }
+    res = runScript(interp, script, cache, jobs);
+    if (cache && cacheStats){
+      cache->printStats(cerr);
+    }
+  }
+  // Reports on stderr come after everything the program printed
+  Output::console().flush();
+  if (memStats){
+    Output err(STDERR_FILENO, false);
+    interp.printStats(err);
+  }
+
+  if (profileOut && !writeProfile(profileOut)){
+    res = 1;
+  }
+  Tracer::close();
+  PerfCounters::close();
+  return res;
+}
+
+static bool writeProfile(const char * path){
+  Profiler * profiler = Profiler::active();
+  profiler->reportFlat(cerr);
+  ofstream collapsed(path);
+  profiler->reportCollapsed(collapsed);
+  if (!collapsed){
+    cerr << "dragoninterp: cannot write profile to " << path << "\n";
+    return false;
+  }
+  return true;
 }
 
-void evaluateCallStmt(StmtNode * callStmt){
-  CallExpNode * callExp = callStmt->getCallExp();
-  if(callExp){
-    SemSymbol * fnSym = symTab->find(callExp->getID()->getName());
-    if(fnSym){
-      std::list<StmtNode *>::iterator it;
-      it = ast->getGlobals()->begin();
-      bool not_found = true;
-      while(not_found && (it != ast->getGlobals()->end())){
-        if ((*it)->isFnDecl() && (*it)->callFnName(callExp->getID()->getName())){
-          not_found = false;
-          (*it)->typeAnalysis(typeAnalysis);
-        }
-        ++it;
+static int runRepl(Interpreter& interp){
+  Input& in = Input::console();
+  Output& out = Output::console();
+  out.put("> Welcome to dragoninterp! Enter HoleyC code to be interpreted...");
+  out.endLine();
+  // Complete statements that have not been run yet. Lines that have
+  // already arrived (a pasted block, or piped input) are gathered so
+  // they are parsed in one pass; the batch runs as soon as reading
+  // on would mean waiting. A statement that reads from the console
+  // ends the batch, since the lines after it may be its input.
+  //
+  // A rejected statement does not end the session, but if any input
+  // failed to parse or name check, the exit status says so.
+  string batch;
+  ReplChunk chunk;
+  string line;
+  int res = 0;
+  auto run = [&](){
+    Status status = interp.evaluate(batch.data(), batch.data() + batch.size());
+    if(status.code == Status::SYNTAX || status.code == Status::NAME){
+      res = 1;
+    }
+    batch.clear();
+    chunk.readsConsole = false;
+  };
+  while(true){
+    if(chunk.complete() && !batch.empty()
+      && (!in.hasBuffered() || chunk.readsConsole)){
+      run();
+    }
+    out.prompt(chunk.prompt().c_str());
+    if(!in.readLine(line)){
+      return res;
+    }
+    if(chunk.complete() && (line == "quit" || line == ":stats")){
+      if(!batch.empty()){
+        run();
       }
+      if(line == "quit"){
+        return res;
+      }
+      interp.printStats(out);
+      continue;
     }
+    chunk.scan(line);
+    batch += line;
+    batch += '\n';
   }
 }
 
-static holeyc::ProgramNode * syntacticAnalysis(std::ifstream *input){
-  if (input == nullptr){
-    return nullptr;
+// Run a whole program file. The file is mapped and scanned in
+// place. The parsed program is looked up in (and stored to) the
+// on-disk cache, if one is configured, and then handed to the
+// interpreter.
+static int runScript(Interpreter& interp, const char * path,
+  CodeCache * cache, size_t jobs){
+  TraceSpan span("input");
+  span.arg("source", path);
+  SourceFile * file = SourceFile::open(path);
+  if (file == nullptr){
+    cerr << "dragoninterp: cannot open " << path << "\n";
+    return 1;
   }
 
-  holeyc::ProgramNode *root = nullptr;
+  // The AST is counted against the session that will free it
+  MemStats::Scope session(&interp.memStats());
+  holeyc::ProgramNode * prog = nullptr;
+  if (cache){
+    TraceSpan lookupSpan("cacheLookup");
+    prog = cache->lookup(file->data(), file->size());
+    lookupSpan.arg("hit", prog ? "true" : "false");
+  }
+  if (prog == nullptr){
+    holeyc::Scanner scanner(file->data(), file->end());
+    prog = Interpreter::parse(scanner);
+    if (prog != nullptr && cache){
+      TraceSpan storeSpan("cacheStore");
+      cache->store(file->data(), file->size(), prog);
+    }
+  }
+  // The AST holds copies of everything it needs from the source
+  delete file;
+  if (prog == nullptr){ return 1; }
 
-  holeyc::Scanner scanner(input);
-#if 1
-  holeyc::Parser parser(scanner, &root);
-#else
-  holeyc::Parser parser(scanner);
-#endif
+  return interp.runProgram(prog, jobs) ? 0 : 1;
+}
 
-  int errCode = parser.parse();
-  if (errCode != 0){
-    return nullptr;
+// Each script's output is printed under a header naming it, with
+// its errors after it, in the order the scripts were given. A summary
+// goes to stderr. Fails if any script did.
+static int runBatchMode(vector<string> paths, size_t jobs,
+  const Limits& limits){
+  if (paths.empty()){
+    string line;
+    while (Input::console().readLine(line)){
+      if (!line.empty()){ paths.push_back(line); }
+    }
   }
+  auto start = chrono::steady_clock::now();
+  vector<BatchResult> results = runBatch(paths, jobs, limits);
+  double ms = chrono::duration<double, milli>(
+    chrono::steady_clock::now() - start).count();
 
-  return root;
+  Output& out = Output::console();
+  size_t failed = 0;
+  for (const BatchResult& result : results){
+    out.put("==> " + result.path + " <==");
+    out.endLine();
+    out.put(result.out);
+    out.put(result.errors);
+    if (!result.ok){ failed++; }
+  }
+  out.flush();
+  cerr << results.size() << " scripts, " << failed << " failed, "
+       << static_cast<long>(ms) << " ms\n";
+  return failed == 0 ? 0 : 1;
 }
 
-static holeyc::NameAnalysis * doNameAnalysis(std::ifstream *input){
-  holeyc::ProgramNode *ast = syntacticAnalysis(input);
-  if (ast == nullptr)
-  {
-    return nullptr;
-  }
+static Server * serving = nullptr;
 
-  return holeyc::NameAnalysis::build(ast);
+static void stopServing(int){
+  if (serving){ serving->stop(); }
 }
 
-static holeyc::TypeAnalysis * doTypeAnalysis(std::ifstream *input){
-  holeyc::NameAnalysis *nameAnalysis = doNameAnalysis(input);
-  if (nameAnalysis == nullptr){
-    return nullptr;
+// Run the preloaded files in order into the library every session
+// starts from (the library is trusted, so it is not held to the
+// limits), then serve until interrupted. Anything the library's
+// own statements write goes to stdout.
+static int runServer(const char * socketPath, const vector<string>& preload,
+  size_t jobs, const Limits& limits){
+  Input none(-1);
+  Interpreter library(none, Output::console());
+  for (const string& path : preload){
+    SourceFile * file = SourceFile::open(path.c_str());
+    if (file == nullptr){
+      cerr << "dragoninterp: cannot open " << path << "\n";
+      return 1;
+    }
+    MemStats::Scope session(&library.memStats());
+    holeyc::Scanner scanner(file->data(), file->end());
+    holeyc::ProgramNode * prog = Interpreter::parse(scanner);
+    delete file;
+    if (prog == nullptr || !library.runProgram(prog, jobs)){ return 1; }
   }
+  Output::console().flush();
 
-  return holeyc::TypeAnalysis::build(nameAnalysis);
-}
\ No newline at end of file
+  Environment env(library);
+  Server server(&env, jobs, limits);
+  if (!server.listen(socketPath)){ return 1; }
+  serving = &server;
+  signal(SIGINT, stopServing);
+  signal(SIGTERM, stopServing);
+  server.run();
+  serving = nullptr;
+  return 0;
+}
@@ -0,0 +1,29 @@
+#include <sys/resource.h>
+
+#include "mem_stats.hpp"
+
+namespace holeyc{
+
+thread_local MemStats * MemStats::active = nullptr;
+MemStats MemStats::process;
+std::atomic<bool> MemStats::heapOn(false);
+
+const char * MemStats::name(Subsystem sys){
+	switch (sys){
+		case TOKENS: return "tokens";
+		case AST: return "AST nodes";
+		case SYMBOLS: return "symbols";
+		case TYPES: return "types";
+		case NODE_TYPES: return "node types";
+		case NUM_SUBSYSTEMS: break;
+	}
+	return "unknown";
+}
+
+size_t MemStats::peakRss(){
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0){ return 0; }
+	return static_cast<size_t>(usage.ru_maxrss);
+}
+
+}
@@ -0,0 +1,139 @@
+#ifndef HOLEYC_MEM_STATS_HPP
+#define HOLEYC_MEM_STATS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace holeyc{
+
+//Where a session's memory goes, for :stats and --stats. Each
+// subsystem's objects are counted as they are allocated and freed:
+// classes through operator new and delete of their own, and the
+// containers they keep through TrackedAllocator.
+//
+//Each interpreter keeps its own counts, and while it is working it
+// is the thread's current one (see Scope), so what it allocates and
+// frees is counted against it and no other session's counters are
+// touched. Anything done outside a session (a benchmark parsing on
+// its own, say) counts against the process. The counters are atomic
+// only because a session's type checking pool shares them; they are
+// only read for reporting, so no ordering is needed.
+//
+//The heap as a whole is counted by whoever replaces the global
+// operator new (dragoninterp does, in main.cpp), and only once
+// startHeapCounting is called. A heap block can be freed by another
+// session than the one that made it, so only allocations are
+// counted, not what is still live.
+class MemStats{
+public:
+	enum Subsystem { TOKENS, AST, SYMBOLS, TYPES, NODE_TYPES,
+		NUM_SUBSYSTEMS };
+
+	//Makes stats the current thread's for as long as it lasts
+	class Scope{
+	public:
+		Scope(MemStats * stats) : outer(active){ active = stats; }
+		~Scope(){ active = outer; }
+	private:
+		MemStats * outer;
+	};
+	static MemStats& current(){ return active ? *active : process; }
+
+	static void allocated(Subsystem sys, size_t bytes){
+		Counter& c = current().counters[sys];
+		c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+		c.live.fetch_add(1, std::memory_order_relaxed);
+		c.total.fetch_add(1, std::memory_order_relaxed);
+	}
+	static void freed(Subsystem sys, size_t bytes){
+		Counter& c = current().counters[sys];
+		c.bytes.fetch_sub(bytes, std::memory_order_relaxed);
+		c.live.fetch_sub(1, std::memory_order_relaxed);
+	}
+	static bool countingHeap(){
+		return heapOn.load(std::memory_order_relaxed);
+	}
+	static void startHeapCounting(){ heapOn = true; }
+	static void heapAllocated(size_t bytes){
+		Counter& c = current().heap;
+		c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+		c.total.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	static const char * name(Subsystem sys);
+	//Bytes and allocations not yet freed, and allocations ever made
+	size_t liveBytes(Subsystem sys) const { return counters[sys].bytes; }
+	size_t liveCount(Subsystem sys) const { return counters[sys].live; }
+	size_t allocations(Subsystem sys) const { return counters[sys].total; }
+	//Bytes and allocations ever made on the heap, while it is counted
+	static bool heapCounted(){ return countingHeap(); }
+	size_t heapBytes() const { return heap.bytes; }
+	size_t heapAllocations() const {
+		return heap.total.load(std::memory_order_relaxed);
+	}
+	//The most resident memory the process has had, in KiB
+	static size_t peakRss();
+
+private:
+	struct Counter{
+		std::atomic<size_t> bytes{0};
+		std::atomic<size_t> live{0};
+		std::atomic<size_t> total{0};
+	};
+	Counter counters[NUM_SUBSYSTEMS];
+	Counter heap;
+	static thread_local MemStats * active;
+	static MemStats process;
+	static std::atomic<bool> heapOn;
+};
+
+//A standard allocator whose allocations are counted against a
+// subsystem. Each call to allocate counts once, however many
+// elements it is for.
+template <typename T, MemStats::Subsystem S>
+class TrackedAllocator{
+public:
+	using value_type = T;
+	template <typename U> struct rebind{
+		using other = TrackedAllocator<U, S>;
+	};
+
+	TrackedAllocator(){ }
+	template <typename U>
+	TrackedAllocator(const TrackedAllocator<U, S>&){ }
+
+	T * allocate(size_t n){
+		MemStats::allocated(S, n * sizeof(T));
+		return static_cast<T *>(::operator new(n * sizeof(T)));
+	}
+	void deallocate(T * ptr, size_t n){
+		MemStats::freed(S, n * sizeof(T));
+		::operator delete(ptr);
+	}
+
+	template <typename U>
+	bool operator==(const TrackedAllocator<U, S>&) const { return true; }
+	template <typename U>
+	bool operator!=(const TrackedAllocator<U, S>&) const { return false; }
+};
+
+template <typename K, typename V, MemStats::Subsystem S>
+using TrackedMap = std::unordered_map<K, V, std::hash<K>,
+	std::equal_to<K>, TrackedAllocator<std::pair<const K, V>, S>>;
+
+template <typename T, MemStats::Subsystem S>
+using TrackedVector = std::vector<T, TrackedAllocator<T, S>>;
+
+template <MemStats::Subsystem S>
+using TrackedString = std::basic_string<char, std::char_traits<char>,
+	TrackedAllocator<char, S>>;
+
+}
+
+#endif
@@ -1,5 +1,6 @@
 #include "ast.hpp"
 #include "symbol_table.hpp"
+#include "string_pool.hpp"
 #include "errName.hpp"
 #include "types.hpp"
 
@@ -93,26 +94,43 @@ bool VarDeclNode::nameAnalysis(SymbolTable * symTab){
 		VarSymbol * sym = new VarSymbol(varName, dataType);
 		ID()->attachSymbol(sym);
 		symTab->insert(sym);
+		//Globals get an address when the declaration runs
+		if (symTab->inFrame()){
+			sym->setFrameOffset(symTab->allocLocal(dataType->getSize()));
+		}
     return true;
 	}
 }
 
 bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
+	return analyze(symTab, nullptr);
+}
+
+bool FnDeclNode::redefine(SymbolTable * symTab, SemSymbol * oldSym){
+	return analyze(symTab, oldSym);
+}
+
+bool FnDeclNode::analyze(SymbolTable * symTab, SemSymbol * oldSym){
 	std::string fnName = this->ID()->getName();
 
 	bool validRet = myRetType->nameAnalysis(symTab);
 
 	// hold onto the scope of the function.
 	ScopeTable * atFnScope = symTab->getCurrentScope();
+	//Note what the function uses from outside itself
+	myUses.clear();
+	symTab->trackUses(&myUses);
 	//Enter a new scope for "within" this function.
 	ScopeTable * inFnScope = symTab->enterScope();
+	//Its formals and locals are laid out in its own frame
+	size_t outerFrame = symTab->enterFrame();
 
 	/*Note that we check for a clash of the function 
 	  name in it's declared scope (e.g. a global
 	  scope for a global function)
 	*/
 	bool validName = true;
-	if (atFnScope->clash(fnName)){
+	if (oldSym == nullptr && atFnScope->clash(fnName)){
 		NameErr::multiDecl(ID()->line(), ID()->col()); 
 		validName = false;
 	}
@@ -132,8 +150,15 @@ bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
 	FnType * dataType = new FnType(formalTypes, retType);
 	//Make sure the fnSymbol is in the symbol table before 
 	// analyzing the body, to allow for recursive calls
-	if (validName){
+	FnSymbol * fnSym = static_cast<FnSymbol *>(oldSym);
+	if (oldSym != nullptr){
+		oldSym->setDataType(dataType);
+	} else if (validName){
 		atFnScope->addFn(fnName, dataType);
+		fnSym = static_cast<FnSymbol *>(atFnScope->lookup(fnName));
+	}
+	if (fnSym != nullptr){
+		fnSym->setDecl(this);
 	}
 
 	bool validBody = true;
@@ -141,7 +166,9 @@ bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
 		validBody = stmt->nameAnalysis(symTab) && validBody;
 	}
 
+	myFrameSize = symTab->leaveFrame(outerFrame);
 	symTab->leaveScope();
+	symTab->stopTrackingUses();
 	return (validRet && validFormals && validName && validBody);
 }
 
@@ -213,7 +240,28 @@ bool CharLitNode::nameAnalysis(SymbolTable * symTab){
 	return true;
 }
 
+//The characters a literal stands for: its lexeme without the
+// quotes, with escapes decoded. The scanner has already rejected
+// any escape other than these.
+static std::string strValue(const std::string& lexeme){
+	std::string res;
+	for (size_t i = 1; i + 1 < lexeme.size(); i++){
+		char ch = lexeme[i];
+		if (ch == '\\'){
+			i++;
+			switch (lexeme[i]){
+			case 'n': ch = '\n'; break;
+			case 't': ch = '\t'; break;
+			default: ch = lexeme[i]; break;
+			}
+		}
+		res += ch;
+	}
+	return res;
+}
+
 bool StrLitNode::nameAnalysis(SymbolTable * symTab){
+	myOffset = symTab->strings()->intern(strValue(myStr));
 	return true;
 }
 
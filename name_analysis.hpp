@@ -2,6 +2,7 @@
 #define HOLEYC_NAME_ANALYSIS
 
 #include "ast.hpp"
+#include "string_pool.hpp"
 
 namespace holeyc{
 
@@ -9,7 +10,10 @@ class NameAnalysis{
 public:
 	static NameAnalysis * build(ProgramNode * astIn){
 		NameAnalysis * nameAnalysis = new NameAnalysis;
-		SymbolTable * symTab = new SymbolTable();
+		//Nothing built this way is run, so the literals it
+		// pools can go with the symbol table
+		StringPool strings;
+		SymbolTable * symTab = new SymbolTable(&strings);
 		bool res = astIn->nameAnalysis(symTab);
 		delete symTab;
 		if (!res){ return nullptr; }
@@ -0,0 +1,84 @@
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#include "output.hpp"
+
+namespace holeyc{
+
+Output& Output::console(){
+	//A function-local static is destroyed (and so flushed) during
+	// normal program exit, including a return from main or exit().
+	static Output out(STDOUT_FILENO, isatty(STDOUT_FILENO) != 0);
+	return out;
+}
+
+Output::Output(int fdIn, bool interactiveIn)
+: myLen(0), fd(fdIn), sink(nullptr), interactive(interactiveIn){
+}
+
+Output::Output(std::string * sinkIn)
+: myLen(0), fd(-1), sink(sinkIn), interactive(false){
+}
+
+Output::~Output(){
+	flush();
+}
+
+Output& Output::put(const char * str, size_t len){
+	if (len > CAPACITY - myLen){
+		flush();
+		//Too large to be worth copying: write it straight through
+		if (len >= CAPACITY){
+			writeAll(str, len);
+			return *this;
+		}
+	}
+	memcpy(myBuf + myLen, str, len);
+	myLen += len;
+	return *this;
+}
+
+Output& Output::put(const char * str){
+	return put(str, strlen(str));
+}
+
+//Format right-to-left into a small scratch buffer. The magnitude
+// is taken as unsigned so that INT_MIN needs no special case.
+Output& Output::putInt(int val){
+	char digits[12];
+	char * end = digits + sizeof(digits);
+	char * pos = end;
+	unsigned int mag = static_cast<unsigned int>(val);
+	if (val < 0){ mag = 0u - mag; }
+	do {
+		*--pos = static_cast<char>('0' + mag % 10);
+		mag /= 10;
+	} while (mag != 0);
+	if (val < 0){ *--pos = '-'; }
+	return put(pos, static_cast<size_t>(end - pos));
+}
+
+void Output::flush(){
+	writeAll(myBuf, myLen);
+	myLen = 0;
+}
+
+void Output::writeAll(const char * str, size_t len){
+	if (sink){
+		sink->append(str, len);
+		return;
+	}
+	while (len > 0){
+		ssize_t res = write(fd, str, len);
+		if (res < 0){
+			if (errno == EINTR){ continue; }
+			//Nowhere left to report a failed write to stdout
+			return;
+		}
+		str += res;
+		len -= static_cast<size_t>(res);
+	}
+}
+
+}
@@ -0,0 +1,65 @@
+#ifndef HOLEYC_OUTPUT_HPP
+#define HOLEYC_OUTPUT_HPP
+
+#include <string>
+
+namespace holeyc{
+
+//A buffered writer for program output. Rather than going through
+// iostreams (which flushes on every endl and formats numbers through
+// the locale machinery), output is collected in a large user-space
+// buffer and handed to the OS in big writes. The buffer is flushed
+// when it fills, at exit, and, if the output is a terminal, at the
+// end of every line so that an interactive session stays responsive.
+class Output{
+public:
+	//The shared writer for standard output. It is flushed
+	// automatically when the program exits.
+	static Output& console();
+
+	Output(int fdIn, bool interactiveIn);
+	//Output that is collected into sink instead of being written
+	// anywhere (it is complete once the Output is flushed)
+	Output(std::string * sinkIn);
+	~Output();
+	Output& put(char c){
+		if (myLen == CAPACITY){ flush(); }
+		myBuf[myLen++] = c;
+		return *this;
+	}
+	Output& put(const char * str, size_t len);
+	Output& put(const char * str);
+	Output& put(const std::string& str){
+		return put(str.data(), str.size());
+	}
+	Output& putInt(int val);
+	Output& putBool(bool val){ return put(val ? '1' : '0'); }
+
+	//Terminate the current line, flushing if interactive
+	void endLine(){
+		put('\n');
+		if (interactive){ flush(); }
+	}
+
+	//Show text that the user is expected to respond to (such as
+	// a REPL prompt). Only a terminal needs it right away.
+	void prompt(const char * str){
+		put(str);
+		if (interactive){ flush(); }
+	}
+
+	void flush();
+	bool isInteractive() const { return interactive; }
+private:
+	void writeAll(const char * str, size_t len);
+	static const size_t CAPACITY = 1 << 16;
+	char myBuf[CAPACITY];
+	size_t myLen;
+	int fd;
+	std::string * sink;
+	bool interactive;
+};
+
+}
+
+#endif
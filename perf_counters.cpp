@@ -0,0 +1,151 @@
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "perf_counters.hpp"
+
+namespace holeyc{
+
+PerfCounters * PerfCounters::current = nullptr;
+
+static const char * PHASE_NAMES[PerfCounters::NUM_PHASES] = {
+	"scan", "parse", "analyze", "execute"
+};
+
+static const char * EVENT_NAMES[PerfCounters::NUM_EVENTS] = {
+	"cycles", "instructions", "branch-misses", "cache-misses"
+};
+
+static const uint64_t EVENT_CONFIGS[PerfCounters::NUM_EVENTS] = {
+	PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES
+};
+
+bool PerfCounters::open(const char * path){
+	PerfCounters * counters = new PerfCounters(path);
+	if (!counters->out){
+		delete counters;
+		return false;
+	}
+	current = counters;
+	return true;
+}
+
+void PerfCounters::close(){
+	if (current == nullptr){ return; }
+	current->write();
+	delete current;
+	current = nullptr;
+}
+
+//Each event is opened on its own rather than as a group, since a
+// group can't be inherited by new threads. Any that the hardware
+// (or a virtual machine, or perf_event_paranoid) won't allow are
+// left out.
+PerfCounters::PerfCounters(const char * path)
+: out(path), numOpen(0){
+	memset(totals, 0, sizeof(totals));
+	memset(estimated, 0, sizeof(estimated));
+	for (int i = 0; i < NUM_EVENTS; i++){
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = EVENT_CONFIGS[i];
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+			| PERF_FORMAT_TOTAL_TIME_RUNNING;
+		attr.inherit = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+			PERF_FLAG_FD_CLOEXEC);
+		fds[i] = static_cast<int>(fd);
+		if (fd >= 0){
+			numOpen++;
+		} else if (why.empty()){
+			why = std::string("perf_event_open: ") + strerror(errno);
+		}
+	}
+}
+
+PerfCounters::~PerfCounters(){
+	for (int fd : fds){
+		if (fd >= 0){ ::close(fd); }
+	}
+}
+
+void PerfCounters::read(Reading * vals){
+	for (int i = 0; i < NUM_EVENTS; i++){
+		uint64_t buf[3] = {0, 0, 0};
+		if (fds[i] >= 0 && ::read(fds[i], buf, sizeof(buf)) != sizeof(buf)){
+			buf[0] = buf[1] = buf[2] = 0;
+		}
+		vals[i].value = buf[0];
+		vals[i].enabled = buf[1];
+		vals[i].running = buf[2];
+	}
+}
+
+//When there are more events than hardware counters, the kernel
+// takes turns with them, and an event only counts while it is
+// running. Its count for the phase is then scaled up by how much of
+// the phase it missed, which is only an estimate, so it is marked as
+// one. (Scaling the running totals instead would spread whatever
+// was missed earlier in the run across every phase.)
+void PerfCounters::add(Phase phase, const Reading * start,
+	const Reading * end){
+	for (int i = 0; i < NUM_EVENTS; i++){
+		if (end[i].value < start[i].value){ continue; }
+		uint64_t count = end[i].value - start[i].value;
+		uint64_t enabled = end[i].enabled - start[i].enabled;
+		uint64_t running = end[i].running - start[i].running;
+		if (running < enabled){
+			estimated[phase][i] = true;
+			count = running == 0 ? 0
+				: static_cast<uint64_t>(static_cast<double>(count)
+					* static_cast<double>(enabled)
+					/ static_cast<double>(running));
+		}
+		totals[phase][i] += count;
+	}
+}
+
+void PerfCounters::deduct(Phase phase, Phase from){
+	for (int i = 0; i < NUM_EVENTS; i++){
+		totals[from][i] = totals[from][i] > totals[phase][i]
+			? totals[from][i] - totals[phase][i] : 0;
+		if (estimated[phase][i]){ estimated[from][i] = true; }
+	}
+}
+
+void PerfCounters::write(){
+	if (!available()){
+		out << "unavailable\t" << why << "\n";
+		return;
+	}
+	out << "#phase";
+	for (const char * name : EVENT_NAMES){
+		out << "\t" << name;
+	}
+	out << "\testimated\n";
+	for (int p = 0; p < NUM_PHASES; p++){
+		out << PHASE_NAMES[p];
+		std::string scaled;
+		for (int i = 0; i < NUM_EVENTS; i++){
+			out << "\t";
+			if (fds[i] < 0){
+				out << "-";
+			} else {
+				out << totals[p][i];
+			}
+			if (estimated[p][i]){
+				scaled += (scaled.empty() ? "" : ",") + std::string(EVENT_NAMES[i]);
+			}
+		}
+		out << "\t" << (scaled.empty() ? "-" : scaled) << "\n";
+	}
+}
+
+}
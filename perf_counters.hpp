@@ -0,0 +1,86 @@
+#ifndef HOLEYC_PERF_COUNTERS_HPP
+#define HOLEYC_PERF_COUNTERS_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace holeyc{
+
+//Hardware performance counters (cycles, instructions, branch misses
+// and cache misses, through perf_event_open) totalled for each phase
+// of running a program, for the benchmark harness. Only user-space
+// events are counted. Threads started after the counters are opened
+// (the type checking pool) count towards them once they finish.
+//
+//When written out, each phase is a line of tab-separated counts,
+// under a header naming them, with "-" for an event the system would
+// not count. The last column names the events whose counts in that
+// phase are estimates (see add), or is "-" if none are. If the system
+// would count none of the events, the file holds a single line saying
+// why instead.
+class PerfCounters{
+public:
+	enum Phase { SCAN, PARSE, ANALYZE, EXECUTE, NUM_PHASES };
+	enum Event { CYCLES, INSTRUCTIONS, BRANCH_MISSES, CACHE_MISSES,
+		NUM_EVENTS };
+
+	//The counters for this run, or nullptr when counting is off
+	static PerfCounters * active(){ return current; }
+	//Count, and write the totals to path on close. Fails only if
+	// path can't be written; missing counters are noted in it.
+	static bool open(const char * path);
+	static void close();
+
+	//An event's count as it stands, with how long it has been
+	// enabled and how long it has actually been counting
+	struct Reading{
+		uint64_t value;
+		uint64_t enabled;
+		uint64_t running;
+	};
+	void read(Reading * vals);
+	//Count what happened between start and end towards phase
+	void add(Phase phase, const Reading * start, const Reading * end);
+	//Take phase's counts out of from's, for a phase that was
+	// counted again inside another
+	void deduct(Phase phase, Phase from);
+	bool available() const { return numOpen > 0; }
+
+private:
+	PerfCounters(const char * path);
+	~PerfCounters();
+	void write();
+	static PerfCounters * current;
+	std::ofstream out;
+	int fds[NUM_EVENTS];
+	int numOpen;
+	std::string why;
+	uint64_t totals[NUM_PHASES][NUM_EVENTS];
+	bool estimated[NUM_PHASES][NUM_EVENTS];
+};
+
+//Counts from its construction to its destruction towards a phase,
+// if counting is on. Otherwise it does nothing.
+class CounterSpan{
+public:
+	CounterSpan(PerfCounters::Phase phaseIn)
+	: counters(PerfCounters::active()), phase(phaseIn){
+		if (counters){ counters->read(start); }
+	}
+	~CounterSpan(){
+		if (counters){
+			PerfCounters::Reading end[PerfCounters::NUM_EVENTS];
+			counters->read(end);
+			counters->add(phase, start, end);
+		}
+	}
+private:
+	PerfCounters * counters;
+	PerfCounters::Phase phase;
+	PerfCounters::Reading start[PerfCounters::NUM_EVENTS];
+};
+
+}
+
+#endif
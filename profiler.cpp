@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "profiler.hpp"
+
+namespace holeyc{
+
+Profiler * Profiler::current = nullptr;
+
+void Profiler::enable(){
+	if (current == nullptr){
+		current = new Profiler();
+	}
+}
+
+//Statements executed outside of any function are charged to
+// the <global> root frame
+Profiler::Profiler() : path("<global>"){ }
+
+void Profiler::enterFn(FnDeclNode * fn){
+	enter(fn, true, fn->ID()->getName());
+}
+
+void Profiler::leaveFn(){
+	leave();
+}
+
+void Profiler::enterStmt(StmtNode * stmt){
+	enter(stmt, false, stmt->nodeKind() + "@" + std::to_string(stmt->line())
+		+ ":" + std::to_string(stmt->col()));
+}
+
+void Profiler::leaveStmt(){
+	leave();
+}
+
+void Profiler::enter(ASTNode * node, bool isFn,
+	const std::string& name){
+	Frame frame;
+	frame.node = node;
+	frame.isFn = isFn;
+	frame.childNs = 0;
+	frame.pathLen = path.size();
+	path += ";";
+	path += name;
+	frames.push_back(frame);
+	//Read the clock last so that bookkeeping isn't charged
+	frames.back().start = Clock::now();
+}
+
+void Profiler::leave(){
+	Clock::time_point stop = Clock::now();
+	Frame& frame = frames.back();
+	uint64_t totalNs = static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(
+		stop - frame.start).count());
+	uint64_t selfNs = totalNs - std::min(totalNs, frame.childNs);
+
+	Stats& stats = frame.isFn ? fnStats[frame.node] : stmtStats[frame.node];
+	stats.count++;
+	stats.selfNs += selfNs;
+	//Don't double count a recursive frame's time
+	bool recursive = false;
+	for (size_t i = 0; i + 1 < frames.size(); i++){
+		if (frames[i].node == frame.node){ recursive = true; }
+	}
+	if (!recursive){ stats.totalNs += totalNs; }
+
+	stacks[path] += selfNs;
+	path.resize(frame.pathLen);
+	frames.pop_back();
+	if (!frames.empty()){
+		frames.back().childNs += totalNs;
+	}
+}
+
+static void printRow(std::ostream& out, uint64_t selfNs, uint64_t totalNs,
+	uint64_t count, const std::string& what){
+	char row[64];
+	snprintf(row, sizeof(row), "%12.3f %12.3f %10llu  ",
+		static_cast<double>(selfNs) / 1e6,
+		static_cast<double>(totalNs) / 1e6,
+		static_cast<unsigned long long>(count));
+	out << row << what << "\n";
+}
+
+template <typename Map>
+static std::vector<typename Map::const_iterator> bySelfTime(const Map& map){
+	std::vector<typename Map::const_iterator> res;
+	for (auto itr = map.begin(); itr != map.end(); ++itr){
+		res.push_back(itr);
+	}
+	std::sort(res.begin(), res.end(),
+		[](typename Map::const_iterator a, typename Map::const_iterator b){
+			return a->second.selfNs > b->second.selfNs;
+		});
+	return res;
+}
+
+void Profiler::reportFlat(std::ostream& out){
+	out << "Flat profile: functions\n";
+	out << "     self ms     total ms      calls  function\n";
+	for (auto entry : bySelfTime(fnStats)){
+		FnDeclNode * fn = static_cast<FnDeclNode *>(entry->first);
+		printRow(out, entry->second.selfNs, entry->second.totalNs,
+			entry->second.count, fn->ID()->getName() + " " + fn->pos());
+	}
+
+	out << "\nFlat profile: statements\n";
+	out << "     self ms     total ms      count  statement\n";
+	for (auto entry : bySelfTime(stmtStats)){
+		StmtNode * stmt = static_cast<StmtNode *>(entry->first);
+		printRow(out, entry->second.selfNs, entry->second.totalNs,
+			entry->second.count, stmt->pos() + " " + stmt->nodeKind());
+	}
+}
+
+void Profiler::reportCollapsed(std::ostream& out){
+	for (auto entry : stacks){
+		out << entry.first << " " << (entry.second / 1000) << "\n";
+	}
+}
+
+}
@@ -0,0 +1,71 @@
+#ifndef HOLEYC_PROFILER_HPP
+#define HOLEYC_PROFILER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ast.hpp"
+
+namespace holeyc{
+
+//An instrumenting profiler. When enabled, every statement and
+// function body that the evaluator runs is bracketed by an enter
+// and a leave call, and the profiler charges the elapsed time and
+// an execution count to that node. Time spent in a nested frame
+// is subtracted to give each frame's self time.
+class Profiler{
+public:
+	//The profiler for this run, or nullptr when profiling is off.
+	// Instrumentation sites check this so that they cost a single
+	// branch when disabled.
+	static Profiler * active(){ return current; }
+	static void enable();
+
+	void enterFn(FnDeclNode * fn);
+	void leaveFn();
+	void enterStmt(StmtNode * stmt);
+	void leaveStmt();
+
+	//A flat profile of functions and statements, each sorted by
+	// self time
+	void reportFlat(std::ostream& out);
+
+	//One line per distinct stack with its self time in
+	// microseconds, the "folded" format read by flamegraph.pl
+	// and speedscope
+	void reportCollapsed(std::ostream& out);
+
+private:
+	Profiler();
+	using Clock = std::chrono::steady_clock;
+
+	struct Stats{
+		Stats() : count(0), totalNs(0), selfNs(0){ }
+		uint64_t count;
+		uint64_t totalNs;
+		uint64_t selfNs;
+	};
+	struct Frame{
+		ASTNode * node;
+		bool isFn;
+		Clock::time_point start;
+		uint64_t childNs;
+		size_t pathLen;
+	};
+
+	void enter(ASTNode * node, bool isFn, const std::string& name);
+	void leave();
+
+	static Profiler * current;
+	std::vector<Frame> frames;
+	std::string path;
+	HashMap<ASTNode *, Stats> fnStats;
+	HashMap<ASTNode *, Stats> stmtStats;
+	HashMap<std::string, uint64_t> stacks;
+};
+
+}
+
+#endif
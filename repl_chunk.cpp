@@ -0,0 +1,23 @@
+#include "repl_chunk.hpp"
+#include "scanner.hpp"
+
+namespace holeyc{
+
+void ReplChunk::scan(const std::string& line){
+	Scanner scanner(line.data(), line.data() + line.size());
+	scanner.setQuiet(true); //the parse reports any errors
+	Parser::semantic_type lval;
+	int kind;
+	while ((kind = scanner.lex(&lval)) != TokenKind::END){
+		if (kind == TokenKind::LCURLY){
+			depth++;
+		} else if (kind == TokenKind::RCURLY && depth > 0){
+			depth--;
+		} else if (kind == TokenKind::FROMCONSOLE){
+			readsConsole = true;
+		}
+		open = kind != TokenKind::SEMICOLON && kind != TokenKind::RCURLY;
+	}
+}
+
+}
@@ -0,0 +1,29 @@
+#ifndef HOLEYC_REPL_CHUNK_HPP
+#define HOLEYC_REPL_CHUNK_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace holeyc{
+
+//Where REPL input stands as lines are entered: how many braces are
+// open and whether anything has been entered since the last
+// statement ended. Each line goes through the scanner on its own (no
+// token spans a line break), so braces inside strings, character
+// literals and comments are never counted.
+struct ReplChunk{
+	size_t depth = 0;
+	bool open = false;
+	bool readsConsole = false;
+	bool complete() const { return depth == 0 && !open; }
+	//Take the next line into account
+	void scan(const std::string& line);
+	//The prompt for the next line
+	std::string prompt() const {
+		return complete() ? "> " : ". " + std::string(depth, '\t');
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,250 @@
+#ifndef HOLEYC_RUNTIME_HPP
+#define HOLEYC_RUNTIME_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <string>
+#include <vector>
+#include "ast.hpp"
+#include "holeyc.hpp"
+#include "string_pool.hpp"
+
+namespace holeyc{
+
+class Dependencies;
+class Input;
+class Output;
+
+//Runs statements once they have passed type analysis. What
+// execution needs from that pass (for example, how to print a
+// value) is recorded on the nodes themselves, so the analysis
+// does not have to be kept.
+//
+//Every variable lives in one contiguous block of memory, and a
+// pointer is an offset into it. Globals are laid out upwards from
+// the bottom; each call pushes a frame for its formals and locals
+// downwards from the top. Nothing is handed out below GUARD, so a
+// single bounds check on every load and store also catches a null
+// pointer (and small indexes off one). The string pool follows the
+// end of memory: it can be read through a pointer like anything
+// else, but storing to it faults.
+//
+//A fault (a bad access, a division by zero, running out of stack)
+// is reported at the statement being run and stops it, along with
+// whatever called it. The next top-level statement starts afresh.
+// Each HoleyC call also nests the evaluator's own C++ calls, so
+// besides the frames in memory the depth of the native stack is
+// watched: a call faults once it is within a margin of the limit.
+//
+//Limits set on the runtime are checked only where it already does
+// work: steps at each call and each time round a loop, and depth
+// and memory as frames and globals are claimed. Unlimited is just a
+// budget too large to run out, so a step costs the same either way.
+// The budget is handed out in slices, and each time one runs out
+// the runtime also checks whether it has been cancelled (see
+// setCancel), so that another thread can stop a runaway statement.
+class Runtime{
+public:
+	static const size_t DEFAULT_CAPACITY = 16 << 20;
+	static const size_t GUARD = 4096;
+
+	//Calls are only made to functions that dependencies says have
+	// passed type analysis. FROMCONSOLE reads from in and TOCONSOLE
+	// writes to out.
+	Runtime(Dependencies * dependencies, StringPool * stringsIn,
+		Input& inIn, Output& outIn, size_t capacity = DEFAULT_CAPACITY);
+	//The globals of a runtime as they stand, for other runtimes to
+	// start from. The pages holding them are mapped into each of
+	// those copy-on-write, so a runtime only gets a page of its own
+	// once it writes to it. Should the system not allow that, a copy
+	// is kept and each runtime copies it in full.
+	class Snapshot{
+	public:
+		explicit Snapshot(const Runtime& from);
+		~Snapshot();
+		Snapshot(const Snapshot&) = delete;
+		Snapshot& operator=(const Snapshot&) = delete;
+	private:
+		friend class Runtime;
+		int fd;
+		std::vector<char> copy;
+		//Whole pages, from address 0
+		size_t bytes;
+		size_t dataTop;
+		size_t capacity;
+	};
+
+	//A runtime that starts out with base's globals (and capacity),
+	// for a session layered over a library. strings must extend the
+	// pool of the runtime base was taken from.
+	Runtime(Dependencies * dependencies, StringPool * stringsIn,
+		Input& inIn, Output& outIn, const Snapshot& base);
+	~Runtime();
+
+	//Run one top-level statement. Returns false if it faulted.
+	bool runTopLevel(StmtNode * stmt);
+
+	//Execute each statement of a body in order, stopping early on
+	// a return or a fault. This is also where the profiler (when
+	// enabled) sees each statement run.
+	void run(std::list<StmtNode *> * body);
+
+	//Call fn with the values of args, evaluated in the caller's
+	// frame. A returned value is left at RETURN_SLOT.
+	void call(FnDeclNode * fn, std::list<ExpNode *> * args);
+	//Call fn, as a top-level statement would, with values from the
+	// host. Returns false if the call faulted.
+	bool callFromHost(FnDeclNode * fn, const std::vector<Value>& args,
+		Value& result);
+	void setLimits(const Limits& limits);
+	//False if the runtime's memory could not be set up (which has
+	// been reported); then every statement and call faults
+	bool hasMemory() const { return mem != nullptr; }
+
+	//What the runtime has used so far. Statements count every one
+	// run, nested ones included; allocations are the heap
+	// allocations (as MemStats counts them) made while statements
+	// were running.
+	struct Usage{
+		size_t globals = 0;
+		size_t calls = 0;
+		size_t peakFrameBytes = 0;
+		uint64_t statements = 0;
+		uint64_t allocations = 0;
+	};
+	const Usage& usage() const { return used; }
+	//Bytes of static storage, the library's included
+	size_t globalBytes() const { return dataTop - GUARD; }
+
+	//Count a loop iteration or a call against the step budget
+	void step(){
+		if (stepsLeft-- == 0){ nextSlice(); }
+	}
+	//Once *flag is set (from any thread), whatever is running faults
+	// within a slice of steps, and so does anything run after it
+	void setCancel(const std::atomic<bool> * flag){ cancel = flag; }
+	void returnFrom(){ if (status == RUNNING){ status = RETURNING; } }
+	bool running() const { return status == RUNNING; }
+	void fault(const char * msg);
+	Input& input(){ return in; }
+	Output& output(){ return out; }
+
+	//Static storage for a global, zeroed
+	size_t allocGlobal(size_t size);
+	//The address of the pooled string at offset
+	size_t stringAddress(size_t offset) const {
+		return myCapacity + offset;
+	}
+	//The base address of the innermost call's frame
+	size_t frame() const { return fp; }
+
+	//Store the value of src, whose type is type, at addr
+	void assign(size_t addr, const DataType * type, ExpNode * src);
+
+	int loadInt(size_t addr){ return load<int>(addr); }
+	bool loadBool(size_t addr){ return load<char>(addr) != 0; }
+	char loadChar(size_t addr){ return load<char>(addr); }
+	size_t loadPtr(size_t addr){ return load<size_t>(addr); }
+	void storeInt(size_t addr, int val){ store(addr, val); }
+	void storeBool(size_t addr, bool val){ store<char>(addr, val); }
+	void storeChar(size_t addr, char val){ store(addr, val); }
+	void storePtr(size_t addr, size_t val){ store(addr, val); }
+	//The NUL-terminated string at addr, in place, or nullptr
+	// (after a fault) if there isn't one in bounds
+	const char * loadString(size_t addr);
+	//The same, without faulting
+	const char * findString(size_t addr) const;
+	//A value of the given type, as the host sees it
+	Value loadValue(size_t addr, const DataType * type);
+	void storeValue(size_t addr, const Value& val);
+
+	//Where a call leaves the value it returns
+	static const size_t RETURN_SLOT = GUARD;
+
+private:
+	enum Status { RUNNING, RETURNING, FAULTED };
+
+	//Whether size more bytes of globals or frames would go over the
+	// memory limit
+	bool overLimit(size_t size) const {
+		size_t used = (dataTop - GUARD) + (myCapacity - sp);
+		return used > maxMemory || size > maxMemory - used;
+	}
+	static const uint64_t SLICE = 1 << 16;
+	void startBudget(){
+		budgetLeft = maxSteps;
+		stepsLeft = 0;
+		depth = 0;
+	}
+	void nextSlice();
+	//Unsigned arithmetic folds the lower and upper bound into a
+	// single comparison
+	bool inBounds(size_t addr, size_t width) const {
+		return addr - GUARD <= myCapacity - GUARD - width;
+	}
+	//Only checked once an address has failed inBounds
+	bool inPool(size_t addr, size_t width) const {
+		return strings->contains(addr - myCapacity, width);
+	}
+	template <typename T> T load(size_t addr){
+		T val = T();
+		if (inBounds(addr, sizeof(T))){
+			memcpy(&val, mem + addr, sizeof(T));
+		} else if (inPool(addr, sizeof(T))){
+			memcpy(&val, strings->at(addr - myCapacity), sizeof(T));
+		} else {
+			badAccess(addr);
+		}
+		return val;
+	}
+	template <typename T> void store(size_t addr, T val){
+		if (inBounds(addr, sizeof(T))){
+			memcpy(mem + addr, &val, sizeof(T));
+		} else if (inPool(addr, sizeof(T))){
+			fault("Write to a string literal");
+		} else {
+			badAccess(addr);
+		}
+	}
+	void badAccess(size_t addr);
+	//Claim a zeroed frame for fn, returning its base
+	size_t pushFrame(FnDeclNode * fn);
+	//Run fn in the frame at calleeFp, then return to the caller's
+	void invoke(FnDeclNode * fn, size_t calleeFp, size_t callerSp);
+
+	bool nativeStackLow() const {
+		char here;
+		return nativeBase - reinterpret_cast<uintptr_t>(&here)
+			> nativeLimit;
+	}
+
+	Dependencies * deps;
+	StringPool * strings;
+	Input& in;
+	Output& out;
+	uintptr_t nativeBase;
+	size_t nativeLimit;
+	char * mem;
+	size_t myCapacity;
+	//Static storage is below dataTop; frames are at or above sp
+	size_t dataTop;
+	size_t sp;
+	size_t fp;
+	Status status;
+	StmtNode * current;
+	uint64_t maxSteps;
+	//Steps left in the current slice, and beyond it
+	uint64_t stepsLeft;
+	uint64_t budgetLeft;
+	const std::atomic<bool> * cancel;
+	size_t maxDepth;
+	size_t depth;
+	size_t maxMemory;
+	Usage used;
+};
+
+}
+
+#endif
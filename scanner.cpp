@@ -1,24 +1,493 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
 #include <fstream>
+#include <iterator>
 #include "scanner.hpp"
 
+//The byte-class loops below have SSE2 versions, which every x86-64
+// target has. Build with -DHOLEYC_NO_SIMD to use only the scalar
+// loops (for comparison, or on other architectures).
+#if defined(__SSE2__) && !defined(HOLEYC_NO_SIMD)
+#define HOLEYC_SCAN_SSE2 1
+#include <emmintrin.h>
+#else
+#define HOLEYC_SCAN_SSE2 0
+#endif
+
 using namespace holeyc;
 
 using TokenKind = holeyc::Parser::token;
 using Lexeme = holeyc::Parser::semantic_type;
 
+namespace{
+
+struct Keyword{
+	const char * word;
+	size_t len;
+	int kind;
+};
+
+//Keywords are found with a perfect hash on an identifier's length
+// and first character: each keyword has a slot of its own, so a
+// lookup is one probe and one memcmp. Changing the keyword set
+// means finding a new hash that keeps the slots distinct.
+const Keyword KEYWORDS[32] = {
+	{ nullptr, 0, 0 },
+	{ "while", 5, TokenKind::WHILE },
+	{ nullptr, 0, 0 },
+	{ "FROMCONSOLE", 11, TokenKind::FROMCONSOLE },
+	{ nullptr, 0, 0 },
+	{ nullptr, 0, 0 },
+	{ "if", 2, TokenKind::IF },
+	{ "int", 3, TokenKind::INT },
+	{ nullptr, 0, 0 },
+	{ nullptr, 0, 0 },
+	{ "intptr", 6, TokenKind::INTPTR },
+	{ nullptr, 0, 0 },
+	{ "bool", 4, TokenKind::BOOL },
+	{ nullptr, 0, 0 },
+	{ "return", 6, TokenKind::RETURN },
+	{ "boolptr", 7, TokenKind::BOOLPTR },
+	{ "char", 4, TokenKind::CHAR },
+	{ nullptr, 0, 0 },
+	{ nullptr, 0, 0 },
+	{ "charptr", 7, TokenKind::CHARPTR },
+	{ "true", 4, TokenKind::TRUE },
+	{ nullptr, 0, 0 },
+	{ nullptr, 0, 0 },
+	{ nullptr, 0, 0 },
+	{ "else", 4, TokenKind::ELSE },
+	{ "TOCONSOLE", 9, TokenKind::TOCONSOLE },
+	{ nullptr, 0, 0 },
+	{ nullptr, 0, 0 },
+	{ "void", 4, TokenKind::VOID },
+	{ "false", 5, TokenKind::FALSE },
+	{ nullptr, 0, 0 },
+	{ "NULLPTR", 7, TokenKind::NULLPTR },
+};
+
+inline size_t keywordSlot(const char * word, size_t len){
+	return (len + (static_cast<size_t>(static_cast<unsigned char>(word[0])) << 2)) & 31;
+}
+
+inline bool isDigit(char ch){
+	return ch >= '0' && ch <= '9';
+}
+
+inline bool isWordStart(char ch){
+	return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_';
+}
+
+inline bool isWordChar(char ch){
+	return isWordStart(ch) || isDigit(ch);
+}
+
+inline bool isBlank(char ch){
+	return ch == ' ' || ch == '\t' || ch == '\n';
+}
+
+#if HOLEYC_SCAN_SSE2
+//Each helper tests 16 bytes at a time and returns a bitmask with
+// bit i set when byte i is *not* in the class being skipped, so the
+// first such byte is at the mask's lowest set bit. Blocks are only
+// loaded while 16 bytes remain; the tail goes through the scalar
+// loop, so nothing past end is ever read (it may be unmapped).
+
+inline unsigned notBlankMask(const char * p){
+	__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+	__m128i blank = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+			_mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+		_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+	return ~static_cast<unsigned>(_mm_movemask_epi8(blank)) & 0xffff;
+}
+
+//lo <= v <= hi, for ASCII bounds (bytes >= 0x80 compare as negative)
+inline __m128i inRange(__m128i v, char lo, char hi){
+	return _mm_and_si128(
+		_mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1))),
+		_mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+inline unsigned notWordMask(const char * p){
+	__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+	//Setting bit 5 folds upper case onto lower case; digits and
+	// '_' are unaffected by it or are tested before folding.
+	__m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+	__m128i word = _mm_or_si128(
+		_mm_or_si128(inRange(lower, 'a', 'z'), inRange(v, '0', '9')),
+		_mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+	return ~static_cast<unsigned>(_mm_movemask_epi8(word)) & 0xffff;
+}
+
+//Bytes that end the plain run of a string literal
+inline unsigned strStopMask(const char * p){
+	__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+	__m128i stop = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+			_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+		_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+	return static_cast<unsigned>(_mm_movemask_epi8(stop));
+}
+
+inline unsigned newlineMask(const char * p){
+	__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+	return static_cast<unsigned>(
+		_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+}
+#endif
+
+//Most runs are a byte or two long (a space, one indent, a short
+// name), where setting up a vector compare costs more than it saves.
+// So the first SCALAR_PREFIX bytes of a run are always tested one at
+// a time and the block loop only takes over for longer runs.
+const int SCALAR_PREFIX = 8;
+
+inline const char * skipBlanks(const char * p, const char * end){
+#if HOLEYC_SCAN_SSE2
+	for (int i = 0; i < SCALAR_PREFIX; i++, p++){
+		if (p == end || !isBlank(*p)){ return p; }
+	}
+	while (end - p >= 16){
+		unsigned mask = notBlankMask(p);
+		if (mask != 0){ return p + __builtin_ctz(mask); }
+		p += 16;
+	}
+#endif
+	while (p < end && isBlank(*p)){ p++; }
+	return p;
+}
+
+inline const char * skipWord(const char * p, const char * end){
+#if HOLEYC_SCAN_SSE2
+	for (int i = 0; i < SCALAR_PREFIX; i++, p++){
+		if (p == end || !isWordChar(*p)){ return p; }
+	}
+	while (end - p >= 16){
+		unsigned mask = notWordMask(p);
+		if (mask != 0){ return p + __builtin_ctz(mask); }
+		p += 16;
+	}
+#endif
+	while (p < end && isWordChar(*p)){ p++; }
+	return p;
+}
+
+//Skips to the next '"', '\\' or newline in a string literal
+inline const char * skipStrText(const char * p, const char * end){
+#if HOLEYC_SCAN_SSE2
+	for (int i = 0; i < SCALAR_PREFIX; i++, p++){
+		if (p == end || *p == '"' || *p == '\\' || *p == '\n'){ return p; }
+	}
+	while (end - p >= 16){
+		unsigned mask = strStopMask(p);
+		if (mask != 0){ return p + __builtin_ctz(mask); }
+		p += 16;
+	}
+#endif
+	while (p < end && *p != '"' && *p != '\\' && *p != '\n'){ p++; }
+	return p;
+}
+
+}
+
+Scanner::Scanner(std::istream *in)
+: source(std::istreambuf_iterator<char>(*in), std::istreambuf_iterator<char>()),
+  lineStarts(1, 0), linesKnownTo(0), hasError(false),
+  quiet(false), timed(false), lexNs(0), tokenCount(0){
+	buf = source.data();
+	pos = buf;
+	end = buf + source.size();
+}
+
+Scanner::Scanner(const char * begin, const char * endIn)
+: buf(begin), pos(begin), end(endIn),
+  lineStarts(1, 0), linesKnownTo(0), hasError(false),
+  quiet(false), timed(false), lexNs(0), tokenCount(0){
+}
+
+//Returns the 1-based line holding offset. lineStarts is extended
+// only as far as the furthest offset asked about; anything before
+// that is a binary search. The parser asks about tokens roughly in
+// order, so nearly every lookup lands on the last known line.
+size_t Scanner::lineAt(size_t offset){
+	if (linesKnownTo < offset){
+		findLines(offset);
+	}
+	if (offset >= lineStarts.back()){
+		return lineStarts.size();
+	}
+	auto after = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+	return static_cast<size_t>(after - lineStarts.begin());
+}
+
+//Records the start of every line that begins after linesKnownTo
+// and at or before upTo. Lines are short, so the SSE2 version
+// handles all the newlines in a 16-byte block from one mask rather
+// than searching again for each one.
+void Scanner::findLines(size_t upTo){
+	size_t at = linesKnownTo;
+#if HOLEYC_SCAN_SSE2
+	for (; upTo - at >= 16; at += 16){
+		unsigned mask = newlineMask(buf + at);
+		while (mask != 0){
+			lineStarts.push_back(at + static_cast<size_t>(__builtin_ctz(mask)) + 1);
+			mask &= mask - 1;
+		}
+	}
+#endif
+	for (; at < upTo; at++){
+		if (buf[at] == '\n'){ lineStarts.push_back(at + 1); }
+	}
+	linesKnownTo = upTo;
+}
+
+//Fill in tok for the len bytes at pos and step past them
+int Scanner::makeToken(Token& tok, int kind, size_t len){
+	tok.myKind = kind;
+	tok.myOffset = static_cast<size_t>(pos - buf);
+	tok.myLength = len;
+	tok.myVal.num = 0;
+	pos += len;
+	return kind;
+}
+
+int Scanner::scan(Token& tok){
+	while (pos < end){
+		char ch = *pos;
+		char next = pos + 1 < end ? pos[1] : '\0';
+		switch (ch){
+		case ' ':
+		case '\t':
+		case '\n':
+			pos = skipBlanks(pos + 1, end);
+			continue;
+		case '\r':
+			if (next != '\n'){ break; }
+			pos += 2;
+			continue;
+		case '#':
+			//Comment. Everything up to the end of the line is skipped
+			pos = static_cast<const char *>(memchr(pos, '\n',
+				static_cast<size_t>(end - pos)));
+			if (pos == nullptr){ pos = end; }
+			continue;
+		case '@': return makeToken(tok, TokenKind::AT, 1);
+		case '^': return makeToken(tok, TokenKind::CARAT, 1);
+		case '[': return makeToken(tok, TokenKind::LBRACE, 1);
+		case ']': return makeToken(tok, TokenKind::RBRACE, 1);
+		case '{': return makeToken(tok, TokenKind::LCURLY, 1);
+		case '}': return makeToken(tok, TokenKind::RCURLY, 1);
+		case '(': return makeToken(tok, TokenKind::LPAREN, 1);
+		case ')': return makeToken(tok, TokenKind::RPAREN, 1);
+		case ';': return makeToken(tok, TokenKind::SEMICOLON, 1);
+		case ',': return makeToken(tok, TokenKind::COMMA, 1);
+		case '*': return makeToken(tok, TokenKind::STAR, 1);
+		case '/': return makeToken(tok, TokenKind::SLASH, 1);
+		case '+':
+			if (next == '+'){ return makeToken(tok, TokenKind::CROSSCROSS, 2); }
+			return makeToken(tok, TokenKind::CROSS, 1);
+		case '-':
+			if (next == '-'){ return makeToken(tok, TokenKind::DASHDASH, 2); }
+			return makeToken(tok, TokenKind::DASH, 1);
+		case '!':
+			if (next == '='){ return makeToken(tok, TokenKind::NOTEQUALS, 2); }
+			return makeToken(tok, TokenKind::NOT, 1);
+		case '=':
+			if (next == '='){ return makeToken(tok, TokenKind::EQUALS, 2); }
+			return makeToken(tok, TokenKind::ASSIGN, 1);
+		case '<':
+			if (next == '='){ return makeToken(tok, TokenKind::LESSEQ, 2); }
+			return makeToken(tok, TokenKind::LESS, 1);
+		case '>':
+			if (next == '='){ return makeToken(tok, TokenKind::GREATEREQ, 2); }
+			return makeToken(tok, TokenKind::GREATER, 1);
+		case '&':
+			if (next == '&'){ return makeToken(tok, TokenKind::AND, 2); }
+			break;
+		case '|':
+			if (next == '|'){ return makeToken(tok, TokenKind::OR, 2); }
+			break;
+		case '\'':
+			if (scanCharLit(tok)){ return TokenKind::CHARLIT; }
+			continue;
+		case '"':
+			if (scanStrLit(tok)){ return TokenKind::STRLITERAL; }
+			continue;
+		default:
+			if (isDigit(ch)){ return scanIntLit(tok); }
+			if (isWordStart(ch)){ return scanWord(tok); }
+			break;
+		}
+
+		errIllegal(pos, std::string(1, ch));
+		pos++;
+	}
+	makeToken(tok, TokenKind::END, 0);
+	return TokenKind::END;
+}
+
+int Scanner::scanWord(Token& tok){
+	const char * wordEnd = skipWord(pos + 1, end);
+	size_t len = static_cast<size_t>(wordEnd - pos);
+
+	const Keyword& kw = KEYWORDS[keywordSlot(pos, len)];
+	if (kw.len == len && memcmp(kw.word, pos, len) == 0){
+		return makeToken(tok, kw.kind, len);
+	}
+	return makeToken(tok, TokenKind::ID, len);
+}
+
+//Digits are accumulated in a single pass, checking for overflow
+// before each step rather than re-parsing the lexeme afterwards.
+int Scanner::scanIntLit(Token& tok){
+	const char * digit = pos;
+	int val = 0;
+	bool overflow = false;
+	for (; digit < end && isDigit(*digit); digit++){
+		int d = *digit - '0';
+		if (val > (INT_MAX - d) / 10){ overflow = true; }
+		if (!overflow){ val = val * 10 + d; }
+	}
+	if (overflow){
+		errIntOverflow(pos);
+		val = INT_MAX;
+	}
+	makeToken(tok, TokenKind::INTLITERAL, static_cast<size_t>(digit - pos));
+	tok.myVal.num = val;
+	return TokenKind::INTLITERAL;
+}
+
+//A character literal is a single quote and the character itself,
+// with no closing quote. Returns false (having reported the
+// problem and skipped the text) for a malformed literal.
+bool Scanner::scanCharLit(Token& tok){
+	size_t left = static_cast<size_t>(end - pos);
+	if (left < 2){
+		errIllegal(pos, "'");
+		pos++;
+		return false;
+	}
+	char ch = pos[1];
+	if (ch == '\n'){
+		errChrEmpty(pos);
+		pos += 2;
+		return false;
+	}
+	if (ch != '\\'){
+		makeToken(tok, TokenKind::CHARLIT, 2);
+		tok.myVal.ch = ch;
+		return true;
+	}
+
+	char esc = left > 2 ? pos[2] : '\n';
+	switch (esc){
+	case 'n': ch = '\n'; break;
+	case 't': ch = '\t'; break;
+	case '\t': ch = '\t'; break;
+	case '\\': ch = '\\'; break;
+	case ' ': ch = ' '; break;
+	case '\n':
+		errChrEscEmpty(pos);
+		pos += 2;
+		return false;
+	default:
+		errChrEsc(pos);
+		pos += 3;
+		return false;
+	}
+	makeToken(tok, TokenKind::CHARLIT, 3);
+	tok.myVal.ch = ch;
+	return true;
+}
+
+//Returns false (having reported the problem) for an unterminated
+// string or one with a bad escape. An unterminated string stops
+// before the newline, which is then scanned as usual.
+bool Scanner::scanStrLit(Token& tok){
+	const char * strEnd = pos + 1;
+	bool badEsc = false;
+	bool terminated = false;
+	while (strEnd < end){
+		strEnd = skipStrText(strEnd, end);
+		if (strEnd == end){ break; }
+		char ch = *strEnd;
+		if (ch == '"'){
+			strEnd++;
+			terminated = true;
+			break;
+		}
+		if (ch == '\n'){ break; }
+		if (ch == '\\'){
+			if (strEnd + 1 == end || strEnd[1] == '\n'){
+				strEnd++;
+				badEsc = true;
+				break;
+			}
+			switch (strEnd[1]){
+			case 'n': case 't': case '\'': case '"': case '\\':
+				break;
+			default:
+				badEsc = true;
+			}
+			strEnd += 2;
+			continue;
+		}
+	}
+
+	size_t len = static_cast<size_t>(strEnd - pos);
+	if (terminated && !badEsc){
+		makeToken(tok, TokenKind::STRLITERAL, len);
+		return true;
+	}
+	if (terminated){
+		errStrEsc(pos);
+	} else if (badEsc){
+		errStrEscAndUnterm(pos);
+	} else {
+		errStrUnterm(pos);
+	}
+	pos = strEnd;
+	return false;
+}
+
+std::string Scanner::tokenString(const Token& tok){
+	std::string res = tokenKindString(tok.kind());
+	switch (tok.kind()){
+	case TokenKind::ID:
+	case TokenKind::STRLITERAL:
+		res += ":" + text(tok);
+		break;
+	case TokenKind::INTLITERAL:
+		res += ":" + std::to_string(tok.num());
+		break;
+	case TokenKind::CHARLIT:
+		res += ":";
+		if (tok.val() == '\n'){ res += "newline"; }
+		else if (tok.val() == '\t'){ res += "tab"; }
+		else { res += std::string(1, tok.val()); }
+		return res;
+	default:
+		break;
+	}
+	return res + " [" + std::to_string(line(tok))
+		+ "," + std::to_string(col(tok)) + "]";
+}
+
 void Scanner::outputTokens(std::ostream& outstream){
-	Lexeme lexeme;
+	Token tok;
 	int tokenKind;
 	while(true){
-		tokenKind = this->yylex(&lexeme);
+		tokenKind = this->scan(tok);
 		if (tokenKind == TokenKind::END){
-			outstream << "EOF" 
-			  << " [" << this->lineNum 
-			  << "," << this->colNum << "]"
+			outstream << "EOF"
+			  << " [" << line(tok)
+			  << "," << col(tok) << "]"
 			  << std::endl;
 			return;
 		} else {
-			outstream << lexeme.transToken->toString()
+			outstream << tokenString(tok)
 			  << std::endl;
 		}
 	}
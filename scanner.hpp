@@ -1,128 +1,159 @@
 #ifndef __HOLYC_SCANNER_HPP__
 #define __HOLYC_SCANNER_HPP__ 1
 
-#if ! defined(yyFlexLexerOnce)
-#include <FlexLexer.h>
-#endif
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
 
 #include "grammar.hh"
 #include "errors.hpp"
+#include "mem_stats.hpp"
 
 using TokenKind = holeyc::Parser::token;
 
 namespace holeyc{
 
-class Scanner : public yyFlexLexer{
+//A hand-written scanner over a single in-memory buffer: either a
+// copy of a stream, or a caller-owned range (such as a mapped file)
+// scanned in place. Tokens point back into that buffer instead of
+// copying their text, so it must outlive the scanner.
+//
+//Line and column numbers are not tracked while scanning. They are
+// worked out from a token's offset when something asks for them
+// (see line and col).
+class Scanner{
 public:
-   
-   Scanner(std::istream *in) : yyFlexLexer(in)
-   {
-	lineNum = 1;
-	colNum = 1;
-	hasError = false;
-   };
-   virtual ~Scanner() {
-   };
-
-   //get rid of override virtual function warning
-   using FlexLexer::yylex;
-
-   // YY_DECL defined in the flex holeyc.l
-   virtual int yylex( holeyc::Parser::semantic_type * const lval);
-
-   int makeBareToken(int tagIn){
-        this->yylval->transToken = new Token(
-	  this->lineNum, this->colNum, tagIn);
-        colNum += static_cast<size_t>(yyleng);
-        return tagIn;
+   Scanner(std::istream *in);
+   Scanner(const char * begin, const char * end);
+
+   // The parser pulls tokens through here. When timing is on, the
+   // time spent scanning is totalled so it can be reported
+   // separately from parsing.
+   int lex( holeyc::Parser::semantic_type * const lval){
+	if (!timed){ return scan(lval->transToken); }
+	auto start = std::chrono::steady_clock::now();
+	int res = scan(lval->transToken);
+	lexNs += static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start).count());
+	tokenCount++;
+	return res;
    }
-
-   int makeCharLitToken(const std::string text){
-	char val;
-	if (text.length() == 2){
-		val = text.c_str()[1];
-	} else if (text == "'\\t"){
-		val = '\t';
-	} else if (text == "'\\n"){
-		val = '\n';
-	} else if (text == "'\\\\"){
-		val = '\\';
-	} else {
-		val = text.c_str()[1];
-	}
-	this->yylval->transToken = new CharLitToken(
-		this->lineNum, this->colNum, val);
-	colNum += static_cast<size_t>(yyleng);
-	return TokenKind::CHARLIT;
+   void setTimed(bool timedIn){ timed = timedIn; }
+   //A quiet scanner notes lexical errors without reporting them,
+   // for callers that only look at the token stream and leave the
+   // reporting to a later, real parse
+   void setQuiet(bool quietIn){ quiet = quietIn; }
+   //The buffer being scanned
+   const char * begin() const { return buf; }
+   const char * limit() const { return end; }
+   uint64_t scanNs() const { return lexNs; }
+   uint64_t tokens() const { return tokenCount; }
+
+   //The source text of an ID or STRLITERAL token (string literals
+   // keep their quotes).
+   std::string text(const Token& tok) const {
+	return std::string(buf + tok.offset(), tok.length());
    }
 
-   void errIllegal(size_t l, size_t c, std::string match){
-	Report::fatal(l, c, "Illegal character "
+   size_t line(const Token& tok){ return lineAt(tok.offset()); }
+   size_t col(const Token& tok){ return colAt(tok.offset()); }
+
+   void errIllegal(const char * at, std::string match){
+	report(at, "Illegal character "
 		+ match);
 	hasError = true;
    }
 
-   void errChrEscEmpty(size_t l, size_t c){
-	Report::fatal(l, c, "Empty escape sequence in"
+   void errChrEscEmpty(const char * at){
+	report(at, "Empty escape sequence in"
 	" character literal");
 	hasError = true;
    }
 
-   void errChrEmpty(size_t l, size_t c){
-	Report::fatal(l, c, "Empty character literal");
+   void errChrEmpty(const char * at){
+	report(at, "Empty character literal");
 	hasError = true;
    }
 
-   void errChrEsc(size_t l, size_t c){
-	Report::fatal(l, c, "Bad escape sequence in"
+   void errChrEsc(const char * at){
+	report(at, "Bad escape sequence in"
 	" char literal");
 	hasError = true;
    }
 
-   void errStrEsc(size_t l, size_t c){
-	Report::fatal(l, c, "String literal with bad"
+   void errStrEsc(const char * at){
+	report(at, "String literal with bad"
 	" escape sequence ignored");
 	hasError = true;
    }
 
-   void errStrUnterm(size_t l, size_t c){
-	Report::fatal(l, c, "Unterminated string"
+   void errStrUnterm(const char * at){
+	report(at, "Unterminated string"
 	" literal ignored");
 	hasError = true;
-	
+
    }
 
-   void errStrEscAndUnterm(size_t l, size_t c){
-	Report::fatal(l, c, "Unterminated string literal"
+   void errStrEscAndUnterm(const char * at){
+	report(at, "Unterminated string literal"
 	"  with bad escape sequence ignored");
 	hasError = true;
    }
 
-   void errIntOverflow(size_t l, size_t c){
-	Report::fatal(l, c, "Integer literal too large;"
+   void errIntOverflow(const char * at){
+	report(at, "Integer literal too large;"
 	"  using max value");
 	hasError = true;
    }
 
    void warn(int lineNumIn, int colNumIn, std::string msg){
-	std::cerr << lineNumIn << ":" << colNumIn 
+	std::cerr << lineNumIn << ":" << colNumIn
 		<< " ***WARNING*** " << msg << std::endl;
    }
 
    void error(int lineNumIn, int colNumIn, std::string msg){
-	std::cerr << lineNumIn << ":" << colNumIn 
+	std::cerr << lineNumIn << ":" << colNumIn
 		<< " ***ERROR*** " << msg << std::endl;
    }
 
-   static std::string tokenKindString(int tokenKind);
+   std::string tokenString(const Token& tok);
 
    void outputTokens(std::ostream& outstream);
 
 private:
-   holeyc::Parser::semantic_type *yylval = nullptr;
-   size_t lineNum;
-   size_t colNum;
+   int scan(Token& tok);
+   int makeToken(Token& tok, int kind, size_t len);
+   bool scanCharLit(Token& tok);
+   bool scanStrLit(Token& tok);
+   int scanIntLit(Token& tok);
+   int scanWord(Token& tok);
+   size_t lineAt(size_t offset);
+   void findLines(size_t upTo);
+   size_t colAt(size_t offset){
+	return offset - lineStarts[lineAt(offset) - 1] + 1;
+   }
+   void report(const char * at, const std::string& msg){
+	if (quiet){ return; }
+	size_t offset = static_cast<size_t>(at - buf);
+	Report::fatal(lineAt(offset), colAt(offset), msg);
+   }
+
+   //Tokens are values, so the memory they account for is the
+   // scanner's: a copy of streamed source, and the line table
+   TrackedString<MemStats::TOKENS> source;
+   const char * buf;
+   const char * pos;
+   const char * end;
+   TrackedVector<size_t, MemStats::TOKENS> lineStarts;
+   size_t linesKnownTo;
    bool hasError;
+   bool quiet;
+   bool timed;
+   uint64_t lexNs;
+   uint64_t tokenCount;
 };
 
 } /* end namespace */
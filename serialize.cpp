@@ -0,0 +1,228 @@
+#include "ast.hpp"
+#include "code_cache.hpp"
+
+namespace holeyc{
+
+void ProgramNode::serialize(ASTWriter& out){
+	out.header(TAG_PROGRAM, this);
+	out.nodes(myGlobals);
+}
+
+void VarDeclNode::serialize(ASTWriter& out){
+	out.header(TAG_VARDECL, this);
+	out.node(myType);
+	out.node(myID);
+}
+
+void FormalDeclNode::serialize(ASTWriter& out){
+	out.header(TAG_FORMALDECL, this);
+	out.node(getTypeNode());
+	out.node(ID());
+}
+
+void FnDeclNode::serialize(ASTWriter& out){
+	out.header(TAG_FNDECL, this);
+	out.node(myRetType);
+	out.node(myID);
+	out.nodes(myFormals);
+	out.nodes(myBody);
+}
+
+void AssignStmtNode::serialize(ASTWriter& out){
+	out.header(TAG_ASSIGNSTMT, this);
+	out.node(myExp);
+}
+
+void FromConsoleStmtNode::serialize(ASTWriter& out){
+	out.header(TAG_FROMCONSOLE, this);
+	out.node(myDst);
+}
+
+void ToConsoleStmtNode::serialize(ASTWriter& out){
+	out.header(TAG_TOCONSOLE, this);
+	out.node(mySrc);
+}
+
+void PostDecStmtNode::serialize(ASTWriter& out){
+	out.header(TAG_POSTDEC, this);
+	out.node(myLVal);
+}
+
+void PostIncStmtNode::serialize(ASTWriter& out){
+	out.header(TAG_POSTINC, this);
+	out.node(myLVal);
+}
+
+void IfStmtNode::serialize(ASTWriter& out){
+	out.header(TAG_IF, this);
+	out.node(myCond);
+	out.nodes(myBody);
+}
+
+void IfElseStmtNode::serialize(ASTWriter& out){
+	out.header(TAG_IFELSE, this);
+	out.node(myCond);
+	out.nodes(myBodyTrue);
+	out.nodes(myBodyFalse);
+}
+
+void WhileStmtNode::serialize(ASTWriter& out){
+	out.header(TAG_WHILE, this);
+	out.node(myCond);
+	out.nodes(myBody);
+}
+
+void ReturnStmtNode::serialize(ASTWriter& out){
+	out.header(TAG_RETURN, this);
+	out.node(myExp); //May be null for a bare return
+}
+
+void CallStmtNode::serialize(ASTWriter& out){
+	out.header(TAG_CALLSTMT, this);
+	out.node(myCallExp);
+}
+
+void CallExpNode::serialize(ASTWriter& out){
+	out.header(TAG_CALLEXP, this);
+	out.node(myID);
+	out.nodes(myArgs);
+}
+
+void AssignExpNode::serialize(ASTWriter& out){
+	out.header(TAG_ASSIGNEXP, this);
+	out.node(myDst);
+	out.node(mySrc);
+}
+
+void BinaryExpNode::serializeBinary(ASTWriter& out, ASTTag tag){
+	out.header(tag, this);
+	out.node(myExp1);
+	out.node(myExp2);
+}
+
+void PlusNode::serialize(ASTWriter& out){
+	serializeBinary(out, TAG_PLUS);
+}
+
+void MinusNode::serialize(ASTWriter& out){
+	serializeBinary(out, TAG_MINUS);
+}
+
+void TimesNode::serialize(ASTWriter& out){
+	serializeBinary(out, TAG_TIMES);
+}
+
+void DivideNode::serialize(ASTWriter& out){
+	serializeBinary(out, TAG_DIVIDE);
+}
+
+void AndNode::serialize(ASTWriter& out){
+	serializeBinary(out, TAG_AND);
+}
+
+void OrNode::serialize(ASTWriter& out){
+	serializeBinary(out, TAG_OR);
+}
+
+void EqualsNode::serialize(ASTWriter& out){
+	serializeBinary(out, TAG_EQUALS);
+}
+
+void NotEqualsNode::serialize(ASTWriter& out){
+	serializeBinary(out, TAG_NOTEQUALS);
+}
+
+void LessNode::serialize(ASTWriter& out){
+	serializeBinary(out, TAG_LESS);
+}
+
+void LessEqNode::serialize(ASTWriter& out){
+	serializeBinary(out, TAG_LESSEQ);
+}
+
+void GreaterNode::serialize(ASTWriter& out){
+	serializeBinary(out, TAG_GREATER);
+}
+
+void GreaterEqNode::serialize(ASTWriter& out){
+	serializeBinary(out, TAG_GREATEREQ);
+}
+
+void NegNode::serialize(ASTWriter& out){
+	out.header(TAG_NEG, this);
+	out.node(myExp);
+}
+
+void NotNode::serialize(ASTWriter& out){
+	out.header(TAG_NOT, this);
+	out.node(myExp);
+}
+
+void IDNode::serialize(ASTWriter& out){
+	out.header(TAG_ID, this);
+	out.str(name);
+}
+
+void RefNode::serialize(ASTWriter& out){
+	out.header(TAG_REF, this);
+	out.node(myID);
+}
+
+void DerefNode::serialize(ASTWriter& out){
+	out.header(TAG_DEREF, this);
+	out.node(myID);
+}
+
+void IndexNode::serialize(ASTWriter& out){
+	out.header(TAG_INDEX, this);
+	out.node(myBase);
+	out.node(myOffset);
+}
+
+void VoidTypeNode::serialize(ASTWriter& out){
+	out.header(TAG_VOIDTYPE, this);
+}
+
+void IntTypeNode::serialize(ASTWriter& out){
+	out.header(TAG_INTTYPE, this);
+	out.byte(isPtr ? 1 : 0);
+}
+
+void BoolTypeNode::serialize(ASTWriter& out){
+	out.header(TAG_BOOLTYPE, this);
+	out.byte(isPtr ? 1 : 0);
+}
+
+void CharTypeNode::serialize(ASTWriter& out){
+	out.header(TAG_CHARTYPE, this);
+	out.byte(isPtr ? 1 : 0);
+}
+
+void IntLitNode::serialize(ASTWriter& out){
+	out.header(TAG_INTLIT, this);
+	out.num(static_cast<unsigned int>(myNum));
+}
+
+void StrLitNode::serialize(ASTWriter& out){
+	out.header(TAG_STRLIT, this);
+	out.str(myStr);
+}
+
+void CharLitNode::serialize(ASTWriter& out){
+	out.header(TAG_CHARLIT, this);
+	out.byte(static_cast<unsigned char>(myVal));
+}
+
+void NullPtrNode::serialize(ASTWriter& out){
+	out.header(TAG_NULLPTR, this);
+}
+
+void TrueNode::serialize(ASTWriter& out){
+	out.header(TAG_TRUE, this);
+}
+
+void FalseNode::serialize(ASTWriter& out){
+	out.header(TAG_FALSE, this);
+}
+
+} //End namespace holeyc
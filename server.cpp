@@ -0,0 +1,410 @@
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "errors.hpp"
+#include "input.hpp"
+#include "interpreter.hpp"
+#include "output.hpp"
+#include "repl_chunk.hpp"
+#include "server.hpp"
+
+namespace holeyc{
+
+//Something a session has been asked to do. Text is sent as it is,
+// once everything before it has been.
+struct Request{
+	enum Kind { EVAL, STATS, TEXT };
+	Kind kind;
+	std::string text;
+};
+
+//A client and its session. Everything but the session is only
+// touched by the I/O thread; the session is only touched by the
+// worker running one of its requests.
+struct Connection{
+	Connection(int fdIn, const Environment * library)
+	: fd(fdIn), in(-1), out(&output), interp(in, out, library){ }
+
+	int fd;
+	//What has been read past the last complete line
+	std::string received;
+	ReplChunk chunk;
+	//Lines of statements not yet asked to be run
+	std::string batch;
+	std::deque<Request *> requests;
+	std::string toSend;
+	//A worker has one of its requests
+	bool busy = false;
+	//Nothing more will be read: close once the requests already
+	// made have been answered
+	bool closing = false;
+	//Nothing more can be sent
+	bool broken = false;
+	//What epoll is watching for, if the fd is registered
+	uint32_t events = 0;
+	bool registered = false;
+
+	std::string output;
+	Input in;
+	Output out;
+	Interpreter interp;
+};
+
+//The most input a client can have sent that is not yet part of a
+// complete statement
+static const size_t MAX_PENDING = 1 << 20;
+
+static const char * WELCOME =
+	"> Welcome to dragoninterp! Enter HoleyC code to be interpreted...\n";
+
+Server::Server(const Environment * libraryIn, size_t workersIn,
+	const Limits& limitsIn)
+: library(libraryIn), numWorkers(workersIn > 0 ? workersIn : 1),
+  limits(limitsIn),
+  listenFd(-1), epollFd(-1), wakeFd(-1), stopped(false),
+  stopping(false){
+}
+
+Server::~Server(){
+	for (auto& entry : connections){
+		Connection * conn = entry.second;
+		for (Request * req : conn->requests){ delete req; }
+		::close(conn->fd);
+		delete conn;
+	}
+	for (auto& job : jobs){ delete job.second; }
+	if (listenFd >= 0){
+		::close(listenFd);
+		unlink(socketPath.c_str());
+	}
+	if (epollFd >= 0){ ::close(epollFd); }
+	if (wakeFd >= 0){ ::close(wakeFd); }
+}
+
+bool Server::listen(const char * path){
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)){
+		Report::error("socket path too long: " + std::string(path));
+		return false;
+	}
+	strcpy(addr.sun_path, path);
+
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (epollFd < 0 || wakeFd < 0 || fd < 0){
+		Report::error("cannot listen on " + std::string(path) + ": "
+			+ strerror(errno));
+		if (fd >= 0){ ::close(fd); }
+		return false;
+	}
+	unlink(path);
+	if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr),
+			sizeof(addr)) < 0
+		|| ::listen(fd, SOMAXCONN) < 0){
+		Report::error("cannot listen on " + std::string(path) + ": "
+			+ strerror(errno));
+		::close(fd);
+		return false;
+	}
+	listenFd = fd;
+	socketPath = path;
+
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = listenFd;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+	ev.data.fd = wakeFd;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+	return true;
+}
+
+void Server::stop(){
+	stopped = true;
+	if (wakeFd >= 0){
+		uint64_t one = 1;
+		ssize_t res = write(wakeFd, &one, sizeof(one));
+	}
+}
+
+void Server::run(){
+	for (size_t i = 0; i < numWorkers; i++){
+		workers.emplace_back(&Server::work, this);
+	}
+	const int MAX_EVENTS = 64;
+	struct epoll_event events[MAX_EVENTS];
+	while (!stopped){
+		int n = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+		if (n < 0){
+			if (errno == EINTR){ continue; }
+			Report::error(std::string("epoll_wait: ") + strerror(errno));
+			break;
+		}
+		for (int i = 0; i < n; i++){
+			int fd = events[i].data.fd;
+			if (fd == listenFd){
+				accept();
+			} else if (fd == wakeFd){
+				uint64_t count;
+				ssize_t res = read(wakeFd, &count, sizeof(count));
+				finished();
+			} else {
+				//An earlier event in this round may have closed it
+				auto found = connections.find(fd);
+				if (found == connections.end()){ continue; }
+				Connection * conn = found->second;
+				if (events[i].events & EPOLLOUT){ send(conn); }
+				if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)){
+					receive(conn);
+				}
+				update(conn);
+			}
+		}
+	}
+	{
+		std::lock_guard<std::mutex> held(lock);
+		stopping = true;
+	}
+	ready.notify_all();
+	for (std::thread& worker : workers){
+		worker.join();
+	}
+	workers.clear();
+}
+
+void Server::accept(){
+	while (true){
+		int fd = accept4(listenFd, nullptr, nullptr,
+			SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0){
+			//EAGAIN once every pending client has been taken. Any
+			// other failure (running out of fds, say) is left for
+			// the next time the socket is ready.
+			return;
+		}
+		Connection * conn = new Connection(fd, library);
+		conn->interp.setLimits(limits);
+		conn->interp.setCancel(&stopped);
+		connections[fd] = conn;
+		conn->toSend = WELCOME;
+		conn->toSend += conn->chunk.prompt();
+		update(conn);
+	}
+}
+
+//Take in whatever has arrived. Complete statements are queued to
+// be run together, as the REPL runs lines that arrive together.
+void Server::receive(Connection * conn){
+	if (conn->closing){ return; }
+	char buf[1 << 14];
+	ssize_t len = read(conn->fd, buf, sizeof(buf));
+	if (len < 0){
+		if (errno == EAGAIN || errno == EINTR){ return; }
+		conn->closing = true;
+		conn->broken = true;
+		return;
+	}
+	conn->received.append(buf, static_cast<size_t>(len));
+	if (len == 0){
+		//The last line need not be terminated
+		conn->closing = true;
+		if (!conn->received.empty()){ conn->received += '\n'; }
+	}
+
+	bool took = false;
+	size_t start = 0;
+	size_t end;
+	while (!conn->broken
+		&& (end = conn->received.find('\n', start)) != std::string::npos){
+		std::string line = conn->received.substr(start, end - start);
+		start = end + 1;
+		bool quit = conn->chunk.complete() && line == "quit";
+		takeLine(conn, line);
+		took = true;
+		if (quit){
+			conn->closing = true;
+			conn->received.clear();
+			return;
+		}
+	}
+	conn->received.erase(0, start);
+	if (took && conn->chunk.complete() && !conn->batch.empty()){
+		conn->requests.push_back(new Request{Request::EVAL, conn->batch});
+		conn->batch.clear();
+	}
+	//A client that never ends its line or its statement is not kept
+	// waiting on for ever
+	if (conn->received.size() + conn->batch.size() > MAX_PENDING){
+		conn->received.clear();
+		conn->batch.clear();
+		conn->requests.push_back(new Request{Request::TEXT,
+			"Input too long: more than " + std::to_string(MAX_PENDING)
+			+ " bytes without a complete statement\n"});
+		conn->closing = true;
+		return;
+	}
+	if (!took){ return; }
+	conn->requests.push_back(new Request{Request::TEXT,
+		conn->chunk.prompt()});
+}
+
+void Server::takeLine(Connection * conn, const std::string& line){
+	if (conn->chunk.complete() && (line == "quit" || line == ":stats")){
+		if (!conn->batch.empty()){
+			conn->requests.push_back(
+				new Request{Request::EVAL, conn->batch});
+			conn->batch.clear();
+		}
+		if (line == ":stats"){
+			conn->requests.push_back(new Request{Request::STATS, ""});
+		}
+		return;
+	}
+	conn->chunk.scan(line);
+	conn->batch += line;
+	conn->batch += '\n';
+}
+
+void Server::send(Connection * conn){
+	while (!conn->toSend.empty()){
+		ssize_t len = ::send(conn->fd, conn->toSend.data(),
+			conn->toSend.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (len < 0){
+			if (errno == EINTR){ continue; }
+			if (errno != EAGAIN && errno != EWOULDBLOCK){
+				//The client has gone: drop what it asked for
+				conn->broken = true;
+				conn->closing = true;
+				conn->toSend.clear();
+			}
+			return;
+		}
+		conn->toSend.erase(0, static_cast<size_t>(len));
+	}
+}
+
+//Hand the connection's next request to a worker (or, if it is only
+// text, send it) unless one of them is already busy with it. Then
+// make epoll watch for what it should, or close the connection if
+// it is finished with.
+void Server::update(Connection * conn){
+	if (conn->broken){
+		for (Request * req : conn->requests){ delete req; }
+		conn->requests.clear();
+	}
+	while (!conn->busy && !conn->requests.empty()){
+		Request * req = conn->requests.front();
+		conn->requests.pop_front();
+		if (req->kind == Request::TEXT){
+			conn->toSend += req->text;
+			delete req;
+			continue;
+		}
+		conn->busy = true;
+		{
+			std::lock_guard<std::mutex> held(lock);
+			jobs.emplace_back(conn, req);
+		}
+		ready.notify_one();
+	}
+	send(conn);
+	if (conn->closing && !conn->busy && conn->requests.empty()
+		&& conn->toSend.empty()){
+		close(conn);
+		return;
+	}
+
+	//A closing connection is left out of epoll while it has nothing
+	// to send, so that a hangup is not reported over and over
+	uint32_t want = 0;
+	if (!conn->closing){ want |= EPOLLIN; }
+	if (!conn->toSend.empty()){ want |= EPOLLOUT; }
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = want;
+	ev.data.fd = conn->fd;
+	if (want == 0){
+		if (conn->registered){
+			epoll_ctl(epollFd, EPOLL_CTL_DEL, conn->fd, &ev);
+			conn->registered = false;
+		}
+	} else if (!conn->registered){
+		epoll_ctl(epollFd, EPOLL_CTL_ADD, conn->fd, &ev);
+		conn->registered = true;
+	} else if (want != conn->events){
+		epoll_ctl(epollFd, EPOLL_CTL_MOD, conn->fd, &ev);
+	}
+	conn->events = want;
+}
+
+//Pass on the replies the workers have finished
+void Server::finished(){
+	std::vector<std::pair<Connection *, std::string>> replies;
+	{
+		std::lock_guard<std::mutex> held(lock);
+		replies.swap(done);
+	}
+	for (auto& reply : replies){
+		Connection * conn = reply.first;
+		conn->busy = false;
+		if (!conn->broken){ conn->toSend += reply.second; }
+		update(conn);
+	}
+}
+
+void Server::close(Connection * conn){
+	if (conn->registered){
+		epoll_ctl(epollFd, EPOLL_CTL_DEL, conn->fd, nullptr);
+	}
+	::close(conn->fd);
+	connections.erase(conn->fd);
+	delete conn;
+}
+
+void Server::work(){
+	std::unique_lock<std::mutex> held(lock);
+	while (true){
+		ready.wait(held, [this]{ return stopping || !jobs.empty(); });
+		if (stopping){ return; }
+		std::pair<Connection *, Request *> job = jobs.front();
+		jobs.pop_front();
+		held.unlock();
+		std::string reply = execute(*job.first, *job.second);
+		delete job.second;
+		held.lock();
+		done.emplace_back(job.first, std::move(reply));
+		uint64_t one = 1;
+		ssize_t res = write(wakeFd, &one, sizeof(one));
+	}
+}
+
+//Everything the request writes, then everything it reports
+std::string Server::execute(Connection& conn, const Request& req){
+	std::vector<Diagnostic> diags;
+	std::vector<Diagnostic> * outer = Report::capture(&diags);
+	if (req.kind == Request::EVAL){
+		conn.interp.evaluate(req.text.data(),
+			req.text.data() + req.text.size());
+	} else {
+		conn.interp.printStats(conn.out);
+	}
+	Report::capture(outer);
+	conn.out.flush();
+	std::string reply;
+	reply.swap(conn.output);
+	for (const Diagnostic& diag : diags){
+		reply += diag.text;
+		reply += '\n';
+	}
+	return reply;
+}
+
+}
@@ -0,0 +1,89 @@
+#ifndef HOLEYC_SERVER_HPP
+#define HOLEYC_SERVER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "holeyc.hpp"
+
+namespace holeyc{
+
+class Environment;
+struct Connection;
+struct Request;
+
+//Serves REPL sessions over a Unix domain socket. Each client that
+// connects gets a session of its own, started from a library's
+// Environment, which was analyzed once, up front, so a request only
+// costs the time it takes to run. A client's input is taken just as
+// the REPL takes it, and it gets back what the REPL would show: the
+// output and then the errors of each batch of complete statements,
+// followed by a prompt.
+//
+//Everything the server sends ends with a newline except a prompt
+// ("> ", or ". " and a tab per open brace while a statement is
+// incomplete), so a reply is complete once what has arrived ends
+// with one.
+//
+//One thread does all of the socket I/O, through epoll, and the
+// statements are run on a pool of workers. A session's requests
+// run one at a time in the order they came in; separate sessions
+// run in parallel. A client that sends more than a megabyte without
+// completing a statement is told so and disconnected.
+class Server{
+public:
+	//Each session starts out with everything library defines, and
+	// is held to limits
+	Server(const Environment * libraryIn, size_t workersIn,
+		const Limits& limitsIn);
+	~Server();
+
+	//Listen at path, replacing any socket already there. Returns
+	// false (having reported why) if that fails.
+	bool listen(const char * path);
+	//Serve clients until stop is called
+	void run();
+	//Safe to call from a signal handler or another thread. Statements
+	// still running are interrupted, so that run returns promptly.
+	void stop();
+
+private:
+	void accept();
+	void receive(Connection * conn);
+	void takeLine(Connection * conn, const std::string& line);
+	void send(Connection * conn);
+	void update(Connection * conn);
+	void finished();
+	void close(Connection * conn);
+	void work();
+	std::string execute(Connection& conn, const Request& req);
+
+	const Environment * library;
+	size_t numWorkers;
+	Limits limits;
+	std::string socketPath;
+	int listenFd;
+	int epollFd;
+	//Written to wake the I/O thread when a request is done or the
+	// server is stopped
+	int wakeFd;
+	std::atomic<bool> stopped;
+	std::unordered_map<int, Connection *> connections;
+
+	//Shared between the I/O thread and the workers
+	std::mutex lock;
+	std::condition_variable ready;
+	std::deque<std::pair<Connection *, Request *>> jobs;
+	std::vector<std::pair<Connection *, std::string>> done;
+	bool stopping;
+	std::vector<std::thread> workers;
+};
+
+}
+
+#endif
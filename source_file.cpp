@@ -0,0 +1,51 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "source_file.hpp"
+
+namespace holeyc{
+
+SourceFile * SourceFile::open(const char * path){
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0){ return nullptr; }
+
+	SourceFile * file = new SourceFile();
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0){
+		size_t len = static_cast<size_t>(st.st_size);
+		void * addr = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr != MAP_FAILED){
+			//The scanner makes a single front-to-back pass
+			madvise(addr, len, MADV_SEQUENTIAL);
+			file->myData = static_cast<const char *>(addr);
+			file->mySize = len;
+			file->mapped = true;
+			close(fd);
+			return file;
+		}
+	}
+
+	char chunk[1 << 16];
+	ssize_t got;
+	while ((got = read(fd, chunk, sizeof(chunk))) > 0){
+		file->myCopy.append(chunk, static_cast<size_t>(got));
+	}
+	close(fd);
+	if (got < 0){
+		delete file;
+		return nullptr;
+	}
+	file->myData = file->myCopy.data();
+	file->mySize = file->myCopy.size();
+	return file;
+}
+
+SourceFile::~SourceFile(){
+	if (mapped){
+		munmap(const_cast<char *>(myData), mySize);
+	}
+}
+
+}
@@ -0,0 +1,35 @@
+#ifndef HOLEYC_SOURCE_FILE_HPP
+#define HOLEYC_SOURCE_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace holeyc{
+
+//The contents of a script file. Regular files are mapped read-only
+// so the scanner can work on them in place; anything that cannot be
+// mapped (a pipe, an empty file) is read into memory instead. The
+// bytes are not NUL-terminated.
+class SourceFile{
+public:
+	//Returns nullptr if path cannot be opened or read
+	static SourceFile * open(const char * path);
+	~SourceFile();
+
+	const char * data() const { return myData; }
+	size_t size() const { return mySize; }
+	const char * end() const { return myData + mySize; }
+private:
+	SourceFile() : myData(nullptr), mySize(0), mapped(false){ }
+	SourceFile(const SourceFile&) = delete;
+	SourceFile& operator=(const SourceFile&) = delete;
+
+	const char * myData;
+	size_t mySize;
+	bool mapped;
+	std::string myCopy;
+};
+
+}
+
+#endif
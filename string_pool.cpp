@@ -0,0 +1,29 @@
+#include "string_pool.hpp"
+
+namespace holeyc{
+
+bool StringPool::find(const std::string& str, size_t& offset) const {
+	if (base && base->find(str, offset)){ return true; }
+	auto found = offsets.find(str);
+	if (found == offsets.end()){ return false; }
+	offset = found->second;
+	return true;
+}
+
+size_t StringPool::intern(const std::string& str){
+	size_t res;
+	if (find(str, res)){ return res; }
+	res = size();
+	myData.insert(myData.end(), str.begin(), str.end());
+	myData.push_back('\0');
+	offsets[str] = res;
+	return res;
+}
+
+bool StringPool::contains(size_t offset, size_t width) const {
+	if (offset < start){ return base->contains(offset, width); }
+	offset -= start;
+	return offset <= myData.size() && myData.size() - offset >= width;
+}
+
+}
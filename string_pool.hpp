@@ -0,0 +1,55 @@
+#ifndef HOLEYC_STRING_POOL_HPP
+#define HOLEYC_STRING_POOL_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace holeyc{
+
+//The text of every string literal, each distinct one stored once
+// (NUL-terminated) however often it appears. Literals are added
+// during name analysis; the runtime then makes the pool readable,
+// but not writable, just past the end of its memory, so a literal's
+// value is an ordinary charptr and using one copies nothing.
+//
+//An entry's offset never changes once it has been added, though
+// the pool's storage may move as it grows.
+//
+//A pool can extend a base pool (a library's, say). The base's
+// entries are used where they are, at the same offsets, and new
+// ones follow them. The base must not grow while it is extended.
+class StringPool{
+public:
+	explicit StringPool(const StringPool * baseIn = nullptr)
+	: base(baseIn), start(baseIn ? baseIn->size() : 0){ }
+
+	//The offset of str, adding it if it isn't already pooled
+	size_t intern(const std::string& str);
+
+	//The text at offset, which must be in the pool
+	const char * at(size_t offset) const {
+		if (offset < start){ return base->at(offset); }
+		return myData.data() + (offset - start);
+	}
+	//Whether width bytes from offset lie within the pool (and
+	// within a single one of the pools it is built from, so that
+	// they can be read from at(offset))
+	bool contains(size_t offset, size_t width) const;
+
+	size_t size() const { return start + myData.size(); }
+	size_t count() const {
+		return (base ? base->count() : 0) + offsets.size();
+	}
+private:
+	bool find(const std::string& str, size_t& offset) const;
+
+	const StringPool * base;
+	size_t start;
+	std::vector<char> myData;
+	std::unordered_map<std::string, size_t> offsets;
+};
+
+}
+
+#endif
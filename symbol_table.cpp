@@ -3,10 +3,19 @@
 #include "types.hpp"
 namespace holeyc{
 
-SymbolTable::SymbolTable(){
+SymbolTable::SymbolTable(StringPool * stringsIn,
+	const FrozenMap<SemSymbol *> * baseIn)
+: base(baseIn), myStrings(stringsIn), uses(nullptr), usesDepth(0), frameSize(0), frameDepth(0){
 	scopeTableChain = new std::list<ScopeTable *>();
 }
 
+SymbolTable::~SymbolTable(){
+	for (ScopeTable * scope : *scopeTableChain){
+		delete scope;
+	}
+	delete scopeTableChain;
+}
+
 void SymbolTable::print(){
 	for(auto scope : *scopeTableChain){
 		std::cout << "--- scope ---\n";
@@ -22,9 +31,10 @@ ScopeTable * SymbolTable::enterScope(){
 
 void SymbolTable::leaveScope(){
 	if (scopeTableChain->empty()){
-		throw new InternalError("Attempt to pop"
-			"empty symbol table");
+		Report::error("Internal error: attempt to pop empty symbol table");
+		return;
 	}
+	delete scopeTableChain->front();
 	scopeTableChain->pop_front();
 }
 
@@ -38,19 +48,55 @@ bool SymbolTable::clash(std::string varName){
 }
 
 SemSymbol * SymbolTable::find(std::string varName){
+	//Scopes are searched innermost first, so depth counts down
+	size_t depth = scopeTableChain->size();
 	for (ScopeTable * scope : *scopeTableChain){
 		SemSymbol * sym = scope->lookup(varName);
-		if (sym != nullptr) { return sym; }
+		if (sym != nullptr) {
+			if (uses != nullptr && depth <= usesDepth){
+				uses->insert(sym);
+			}
+			return sym;
+		}
+		depth--;
 	}
-	return nullptr;
+	if (base == nullptr){ return nullptr; }
+	SemSymbol * const * sym = base->find(varName);
+	if (sym == nullptr){ return nullptr; }
+	if (uses != nullptr){ uses->insert(*sym); }
+	return *sym;
 }
 
 bool SymbolTable::insert(SemSymbol * symbol){
 	return scopeTableChain->front()->insert(symbol);
 }
 
+void * SemSymbol::operator new(size_t size){
+	MemStats::allocated(MemStats::SYMBOLS, size);
+	return ::operator new(size);
+}
+
+void SemSymbol::operator delete(void * ptr, size_t size){
+	MemStats::freed(MemStats::SYMBOLS, size);
+	::operator delete(ptr);
+}
+
+void * ScopeTable::operator new(size_t size){
+	MemStats::allocated(MemStats::SYMBOLS, size);
+	return ::operator new(size);
+}
+
+void ScopeTable::operator delete(void * ptr, size_t size){
+	MemStats::freed(MemStats::SYMBOLS, size);
+	::operator delete(ptr);
+}
+
 ScopeTable::ScopeTable(){
-	symbols = new HashMap<std::string, SemSymbol *>();
+	symbols = new SymbolMap();
+}
+
+ScopeTable::~ScopeTable(){
+	delete symbols;
 }
 
 std::string ScopeTable::toString(){
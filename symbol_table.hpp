@@ -2,7 +2,10 @@
 #define HOLEYC_SYMBOL_TABLE_HPP
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <list>
+#include "frozen_map.hpp"
+#include "mem_stats.hpp"
 #include "types.hpp"
 
 //Use an alias template so that we can use
@@ -16,6 +19,9 @@ using namespace std;
 
 namespace holeyc{
 
+class FnDeclNode;
+class StringPool;
+
 enum SymbolKind {
 	VAR, FN
 };
@@ -28,6 +34,11 @@ class SemSymbol {
 public:
 	SemSymbol(std::string nameIn, DataType * typeIn) 
 	: myName(nameIn), myType(typeIn){ }
+	virtual ~SemSymbol(){ }
+	//Symbols (and scopes) are allocated through these so that they
+	// are counted in MemStats
+	static void * operator new(size_t size);
+	static void operator delete(void * ptr, size_t size);
 	virtual std::string toString();
 	std::string getName() const { return myName; }
 	virtual SymbolKind getKind() const = 0;
@@ -35,6 +46,9 @@ public:
 	virtual DataType * getDataType() const{
 		return myType;
 	}
+	void setDataType(DataType * typeIn){
+		myType = typeIn;
+	}
 	static std::string kindToString(SymbolKind symKind) { 
 		switch(symKind){
 			case VAR: return "var";
@@ -42,48 +56,27 @@ public:
 		}
 		return "UNKNOWN KIND";
 	}
-  
-  void addIntValue(int val) {
-    valType = "int";
-    myValInt = val;
-  }
-  void addBoolValue(bool val) {
-    valType = "bool";
-    myValBool = val;
-  }
-  void addCharValue(char val) {
-    valType = "char";
-    myValChar = val;
-  }
-
-  string getValType(){
-    return valType;
-  }
-
-  int * getIntVal() {
-    int * val = new int;
-    *val = myValInt;
-    return val;
-  }
-  char * getCharVal() {
-    char * val = new char;
-    *val = myValChar;
-    return val;
-  }
-  bool * getBoolVal() {
-    bool * val = new bool;
-    *val = myValBool;
-    return val;
-  }
+
+	//Where a variable lives at runtime. A global has a fixed
+	// address, given to it when its declaration runs. A local or
+	// formal has an offset into the frame of each call, given to it
+	// by name analysis.
+	void setAddress(size_t addrIn){
+		myAddr = addrIn;
+		local = false;
+	}
+	void setFrameOffset(size_t offsetIn){
+		myAddr = offsetIn;
+		local = true;
+	}
+	size_t getAddress() const { return myAddr; }
+	bool isLocal() const { return local; }
 
 private:
 	std::string myName;
-  DataType * myType;
-  std::string myValString; // CLB: 11/21/20
-  string valType = ""; 
-  int myValInt; // CLB: 11/21/20
-  char myValChar; // CLB: 11/21/20
-  bool myValBool; // CLB: 11/21/20
+	DataType * myType;
+	size_t myAddr = 0;
+	bool local = false;
 };
 
 class VarSymbol : public SemSymbol {
@@ -99,6 +92,12 @@ public:
 	: SemSymbol(name, fnType){ }
 	virtual SymbolKind getKind() const { return FN; }
 	SymbolKind getKind(){ return FN; } 
+	//The definition that calls through this symbol run. A REPL
+	// redefinition keeps the symbol and replaces the definition.
+	void setDecl(FnDeclNode * declIn){ myDecl = declIn; }
+	FnDeclNode * getDecl() const { return myDecl; }
+private:
+	FnDeclNode * myDecl = nullptr;
 };
 
 //A single scope. The symbol table is broken down into a 
@@ -107,11 +106,21 @@ public:
 // the globals scope will be represented by a ScopeTable,
 // and the contents of each function can be represented by
 // a ScopeTable.
+//The symbols of a scope, by name
+using SymbolMap = TrackedMap<std::string, SemSymbol *, MemStats::SYMBOLS>;
+
 class ScopeTable {
 	public:
 		ScopeTable();
+		//The symbols themselves are left alone: the nodes that
+		// were bound to them still refer to them
+		~ScopeTable();
+		static void * operator new(size_t size);
+		static void operator delete(void * ptr, size_t size);
 		SemSymbol * lookup(std::string name);
 		bool insert(SemSymbol * symbol);
+		//Take back an insert (of a declaration that was rejected)
+		void remove(std::string name){ symbols->erase(name); }
 		bool clash(std::string name);
 		std::string toString();
 		void addVar(std::string name, DataType * type){
@@ -120,16 +129,25 @@ class ScopeTable {
 		void addFn(std::string name, FnType * type){
 			insert(new FnSymbol(name, type));
 		}
+		const SymbolMap * getSymbols() const {
+			return symbols;
+		}
 	private:
-		HashMap<std::string, SemSymbol *> * symbols;
+		SymbolMap * symbols;
 };
 
 class SymbolTable{
 	public:
-		SymbolTable();
+		//String literals met during analysis are added to strings.
+		// If there is a base (a library's globals), names not found
+		// in any open scope are looked up there.
+		SymbolTable(StringPool * stringsIn,
+			const FrozenMap<SemSymbol *> * baseIn = nullptr);
+		~SymbolTable();
 		ScopeTable * enterScope();
 		void leaveScope();
 		ScopeTable * getCurrentScope();
+		ScopeTable * getGlobalScope(){ return scopeTableChain->back(); }
 		bool insert(SemSymbol * symbol);
 		SemSymbol * find(std::string varName);
 		bool clash(std::string name);
@@ -140,8 +158,49 @@ class SymbolTable{
 			getCurrentScope()->addFn(name, type);
 		}
 		void print();
+		//Until stopTrackingUses, every symbol that find returns
+		// from one of the scopes open right now is added to uses.
+		// This is how a function's references to globals are found.
+		void trackUses(std::unordered_set<SemSymbol *> * usesIn){
+			uses = usesIn;
+			usesDepth = scopeTableChain->size();
+		}
+		void stopTrackingUses(){ uses = nullptr; }
+		//While a frame is open (that is, while a function is being
+		// analyzed), variables are laid out in it rather than made
+		// global. enterFrame returns the size of the enclosing
+		// frame so far, which leaveFrame takes back; leaveFrame
+		// returns the size of the frame it closes.
+		size_t enterFrame(){
+			size_t outer = frameSize;
+			frameSize = 0;
+			frameDepth++;
+			return outer;
+		}
+		size_t leaveFrame(size_t outer){
+			size_t res = frameSize;
+			frameSize = outer;
+			frameDepth--;
+			return res;
+		}
+		bool inFrame() const { return frameDepth > 0; }
+		StringPool * strings(){ return myStrings; }
+		//The offset of a new slot of the given size in the open
+		// frame, aligned to that size
+		size_t allocLocal(size_t size){
+			frameSize = (frameSize + size - 1) / size * size;
+			size_t res = frameSize;
+			frameSize += size;
+			return res;
+		}
 	private:
 		std::list<ScopeTable *> * scopeTableChain;
+		const FrozenMap<SemSymbol *> * base;
+		StringPool * myStrings;
+		std::unordered_set<SemSymbol *> * uses;
+		size_t usesDepth;
+		size_t frameSize;
+		size_t frameDepth;
 };
 
 	
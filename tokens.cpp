@@ -4,9 +4,8 @@
 namespace holeyc{
 
 using TokenKind = holeyc::Parser::token;
-using Lexeme = holeyc::Parser::semantic_type;
 
-static std::string tokenKindString(int tokKind){
+std::string tokenKindString(int tokKind){
 	switch(tokKind){
 		case TokenKind::END: return "EOF";
 		case TokenKind::AND: return "AND";
@@ -60,89 +59,4 @@ static std::string tokenKindString(int tokKind){
 	
 }
 
-Token::Token(size_t lineIn, size_t columnIn, int kindIn)
-  : myLine(lineIn), myCol(columnIn), myKind(kindIn){
-}
-
-std::string Token::toString(){
-	return tokenKindString(kind())
-	+ " [" + std::to_string(line()) 
-	+ "," + std::to_string(col()) + "]";
-}
-
-size_t Token::line() const { 
-	return this->myLine; 
-}
-
-size_t Token::col() const { 
-	return this->myCol; 
-}
-
-int Token::kind() const { 
-	return this->myKind; 
-}
-
-IDToken::IDToken(size_t lIn, size_t cIn, std::string vIn)
-  : Token(lIn, cIn, TokenKind::ID), myValue(vIn){ 
-}
-
-std::string IDToken::toString(){
-	return tokenKindString(kind()) + ":"
-	+ this->myValue
-	+ " [" + std::to_string(line()) 
-	+ "," + std::to_string(col()) + "]";
-}
-
-const std::string IDToken::value() const { 
-	return this->myValue; 
-}
-
-StrToken::StrToken(size_t lIn, size_t cIn, std::string sIn)
-  : Token(lIn, cIn, TokenKind::STRLITERAL), myStr(sIn){
-}
-
-std::string StrToken::toString(){
-	return tokenKindString(kind()) + ":"
-	+ this->myStr
-	+ " [" + std::to_string(line()) 
-	+ "," + std::to_string(col()) + "]";
-}
-
-const std::string StrToken::str() const {
-	return this->myStr;
-}
-
-CharLitToken::CharLitToken(size_t lIn, size_t cIn, char valIn)
-  : Token(lIn, cIn, TokenKind::CHARLIT), myVal(valIn){
-}
-
-std::string CharLitToken::toString() {
-	std::string res = tokenKindString(kind()) + ":";
-
-	char v = this->val();
-	if (v == '\n'){ res += "newline"; }
-	else if (v == '\t'){ res += "tab"; }
-	else { res += std::string(1, v); }
-
-	return res;
-}
-
-char CharLitToken::val() const {
-	return this->myVal;
-}
-
-IntLitToken::IntLitToken(size_t lIn, size_t cIn, int numIn)
-  : Token(lIn, cIn, TokenKind::INTLITERAL), myNum(numIn){}
-
-std::string IntLitToken::toString(){
-	return tokenKindString(kind()) + ":"
-	+ std::to_string(this->myNum)
-	+ " [" + std::to_string(line()) 
-	+ "," + std::to_string(col()) + "]";
-}
-
-int IntLitToken::num() const {
-	return this->myNum;
-}
-
 } //End namespace holeyc
@@ -1,59 +1,34 @@
 #ifndef HOLYC_TOKEN_H
 #define HOLYC_TOKEN_H
 
+#include <cstddef>
 #include <string>
 
 namespace holeyc{
 
-class Token{
-public:
-	Token(size_t lineIn, size_t columnIn, int kindIn);
-	virtual std::string toString();
-	size_t line() const;
-	size_t col() const;
-	int kind() const;
-private:
-	const size_t myLine;
-	const size_t myCol;
-	const int myKind;
+//Tokens are plain values that the parser receives by copy, so
+// scanning allocates nothing per token. A token records where its
+// lexeme starts in the scanner's source buffer and how long it is.
+// Text, line and column are all recovered from the offset by the
+// scanner (Scanner::text, Scanner::line, Scanner::col) when the
+// parser builds a node.
+struct Token{
+	int myKind;
+	size_t myOffset;
+	size_t myLength;
+	union {
+		int num;  //INTLITERAL
+		char ch;  //CHARLIT
+	} myVal;
+
+	int kind() const { return myKind; }
+	size_t offset() const { return myOffset; }
+	size_t length() const { return myLength; }
+	int num() const { return myVal.num; }
+	char val() const { return myVal.ch; }
 };
 
-class IDToken : public Token{
-public:
-	IDToken(size_t lIn, size_t cIn, std::string valIn);
-	const std::string value() const;
-	virtual std::string toString() override;
-private:
-	const std::string myValue;
-	
-};
-
-class StrToken : public Token{
-public:
-	StrToken(size_t lIn, size_t cIn, std::string valIn);
-	virtual std::string toString() override;
-	const std::string str() const;
-private:
-	const std::string myStr;
-};
-
-class CharLitToken : public Token{
-public:
-	CharLitToken(size_t lIn, size_t cIn, char valIn);
-	virtual std::string toString() override;
-	char val() const;
-private:
-	const char myVal;
-};
-
-class IntLitToken : public Token{
-public:
-	IntLitToken(size_t lIn, size_t cIn, int numIn);
-	virtual std::string toString() override;
-	int num() const;
-private:
-	const int myNum;
-};
+std::string tokenKindString(int tokKind);
 
 }
 
@@ -0,0 +1,86 @@
+#include <cstdio>
+
+#include "trace.hpp"
+
+namespace holeyc{
+
+Tracer * Tracer::current = nullptr;
+
+bool Tracer::open(const char * path){
+	Tracer * tracer = new Tracer(path);
+	if (!tracer->out){
+		delete tracer;
+		return false;
+	}
+	current = tracer;
+	return true;
+}
+
+void Tracer::close(){
+	if (current == nullptr){ return; }
+	current->out << "\n]}\n";
+	delete current;
+	current = nullptr;
+}
+
+Tracer::Tracer(const char * path)
+: out(path), epoch(std::chrono::steady_clock::now()), first(true){
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+}
+
+uint64_t Tracer::now() const{
+	return static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - epoch).count());
+}
+
+//Trace timestamps are in microseconds; keep the nanoseconds as
+// a fraction so that short phases don't round to zero.
+void Tracer::span(const char * name, uint64_t startNs, uint64_t durNs,
+	const std::string& args){
+	char times[64];
+	snprintf(times, sizeof(times), "\"ts\":%llu.%03llu,\"dur\":%llu.%03llu",
+		static_cast<unsigned long long>(startNs / 1000),
+		static_cast<unsigned long long>(startNs % 1000),
+		static_cast<unsigned long long>(durNs / 1000),
+		static_cast<unsigned long long>(durNs % 1000));
+	out << (first ? "\n" : ",\n");
+	first = false;
+	out << "{\"name\":\"" << name << "\",\"cat\":\"dragoninterp\","
+		<< "\"ph\":\"X\",\"pid\":1,\"tid\":1," << times;
+	if (!args.empty()){
+		out << ",\"args\":{" << args << "}";
+	}
+	out << "}";
+}
+
+static std::string jsonString(const std::string& val){
+	std::string res = "\"";
+	for (char c : val){
+		if (c == '"' || c == '\\'){
+			res += '\\';
+			res += c;
+		} else if (static_cast<unsigned char>(c) < 0x20){
+			char esc[8];
+			snprintf(esc, sizeof(esc), "\\u%04x", c);
+			res += esc;
+		} else {
+			res += c;
+		}
+	}
+	return res + "\"";
+}
+
+void TraceSpan::arg(const char * key, const std::string& val){
+	if (!tracer){ return; }
+	if (!args.empty()){ args += ","; }
+	args += jsonString(key) + ":" + jsonString(val);
+}
+
+void TraceSpan::arg(const char * key, uint64_t val){
+	if (!tracer){ return; }
+	if (!args.empty()){ args += ","; }
+	args += jsonString(key) + ":" + std::to_string(val);
+}
+
+}
@@ -0,0 +1,60 @@
+#ifndef HOLEYC_TRACE_HPP
+#define HOLEYC_TRACE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace holeyc{
+
+//Writes interpreter phase timings as Chrome trace events (the
+// JSON format loaded by chrome://tracing and Perfetto). Events are
+// streamed to the file as they complete, so a long session doesn't
+// hold them all in memory.
+class Tracer{
+public:
+	//The tracer for this run, or nullptr when tracing is off
+	static Tracer * active(){ return current; }
+	static bool open(const char * path);
+	static void close();
+
+	//Nanoseconds since the trace was opened
+	uint64_t now() const;
+
+	//Record a span that started at startNs and ran for durNs.
+	// args, if given, is the body of a JSON object.
+	void span(const char * name, uint64_t startNs, uint64_t durNs,
+		const std::string& args = "");
+private:
+	Tracer(const char * path);
+	static Tracer * current;
+	std::ofstream out;
+	std::chrono::steady_clock::time_point epoch;
+	bool first;
+};
+
+//Records a span from its construction to its destruction, if
+// tracing is on. Otherwise it does nothing.
+class TraceSpan{
+public:
+	TraceSpan(const char * nameIn)
+	: tracer(Tracer::active()), name(nameIn),
+	  start(tracer ? tracer->now() : 0){ }
+	~TraceSpan(){
+		if (tracer){
+			tracer->span(name, start, tracer->now() - start, args);
+		}
+	}
+	void arg(const char * key, const std::string& val);
+	void arg(const char * key, uint64_t val);
+private:
+	Tracer * tracer;
+	const char * name;
+	uint64_t start;
+	std::string args;
+};
+
+}
+
+#endif
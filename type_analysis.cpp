@@ -1,4 +1,6 @@
 #include <assert.h>
+#include <atomic>
+#include <thread>
 
 #include "name_analysis.hpp"
 #include "type_analysis.hpp"
@@ -19,6 +21,55 @@ TypeAnalysis * TypeAnalysis::build(NameAnalysis * nameAnalysis){
 
 }
 
+//Statements are handed out one at a time, since function bodies
+// vary a lot in size. Each node is only ever looked at by the
+// thread checking the statement it belongs to; what the statements
+// share (symbols and types) is only read, apart from the pointer
+// type flyweights, which are locked. The workers count their
+// allocations against the session that started them.
+void TypeAnalysis::checkAll(const std::vector<StmtNode *>& stmts,
+	std::vector<char>& passed, size_t threads){
+	passed.assign(stmts.size(), 0);
+	if (threads > stmts.size()){ threads = stmts.size(); }
+	if (threads == 0){ threads = 1; }
+	std::vector<std::vector<Diagnostic>> diags(threads);
+	std::atomic<size_t> next(0);
+	MemStats * session = &MemStats::current();
+	auto work = [&](size_t worker){
+		MemStats::Scope counted(session);
+		auto outer = Report::capture(&diags[worker]);
+		size_t i;
+		while ((i = next.fetch_add(1)) < stmts.size()){
+			TypeAnalysis typing;
+			stmts[i]->typeAnalysis(&typing);
+			passed[i] = typing.passed();
+		}
+		Report::capture(outer);
+	};
+	std::vector<std::thread> workers;
+	for (size_t w = 1; w < threads; w++){
+		workers.emplace_back(work, w);
+	}
+	work(0);
+	for (std::thread& worker : workers){
+		worker.join();
+	}
+
+	std::vector<Diagnostic> all;
+	for (auto& some : diags){
+		all.insert(all.end(), some.begin(), some.end());
+	}
+	Report::flush(all);
+}
+
+//Type analysis only checks. Nothing is run here: see
+// execute.cpp, which relies on the types recorded by this pass.
+static void typeBody(TypeAnalysis * typing, std::list<StmtNode *> * body){
+	for (auto stmt : *body){
+		stmt->typeAnalysis(typing);
+	}
+}
+
 void ProgramNode::typeAnalysis(TypeAnalysis * typing){
 	for (auto decl : *myGlobals){
 		decl->typeAnalysis(typing);
@@ -53,9 +104,7 @@ void FnDeclNode::typeAnalysis(TypeAnalysis * typing){
 	typing->nodeType(this, new FnType(formalTypes, retDataType));
 
 	typing->setCurrentFnType(typing->nodeType(this)->asFn());
-	for (auto stmt : *myBody){
-		stmt->typeAnalysis(typing);
-	}
+	typeBody(typing, myBody);
 	typing->setCurrentFnType(nullptr);
 }
 
@@ -88,6 +137,8 @@ static const DataType * typeAssignOpd(TypeAnalysis * typing, ExpNode * opd){
 void AssignExpNode::typeAnalysis(TypeAnalysis * typing){
 	const DataType * dstType = typeAssignOpd(typing, myDst);
   const DataType * srcType = typeAssignOpd(typing, mySrc);
+	myDstType = dstType;
+	mySrcType = srcType;
 
   if (!dstType || !srcType){
     typing->nodeType(this, ErrorType::produce());
@@ -96,18 +147,6 @@ void AssignExpNode::typeAnalysis(TypeAnalysis * typing){
 
 	if (dstType == srcType){
     typing->nodeType(this, dstType);
-    if(dstType->isInt()){
-      int * val = mySrc->getIntValue();
-      myDst->addValueToSymbol(val,nullptr,nullptr);
-    } else if (dstType->isBool()){
-      bool * val = mySrc->getBoolValue();
-      myDst->addValueToSymbol(nullptr,val,nullptr);
-    } else if (dstType->isChar()) {
-      char * val = mySrc->getCharValue();
-      myDst->addValueToSymbol(nullptr,nullptr,val);
-    } else {
-      throw new InternalError("LHS must be Int, Bool or Char\n");
-    }
 		return;
 	}
 
@@ -126,17 +165,6 @@ void AssignExpNode::typeAnalysis(TypeAnalysis * typing){
 	return;
 }
 
-void IDNode::addValueToSymbol(int *valInt, bool *valBool, char *valChar) {
-  if(valInt){
-    mySymbol->addIntValue(*valInt);
-  } else if (valBool) {
-    mySymbol->addBoolValue(*valBool);
-  } else if (valChar) {
-    mySymbol->addCharValue(*valChar);
-  } else {
-  }
-}
-
 void CallExpNode::typeAnalysis(TypeAnalysis * typing){
 
 	std::list<const DataType *> * aList = new std::list<const DataType *>();
@@ -288,6 +316,7 @@ void IndexNode::typeAnalysis(TypeAnalysis * typing){
 
 	if (const PtrType * asPtr = baseType->asPtr()){
 		typing->nodeType(this, asPtr->decLevel());
+		myElemSize = asPtr->decLevel()->getSize();
 	} else {
 		typing->badPtrBase(myBase->line(), myBase->col());
 	}
@@ -404,7 +433,7 @@ void BinaryExpNode::binaryLogicTyping(TypeAnalysis * typing){
 
 	//We never expect to get here, so we'll consider it
 	// an error with the compiler itself
-	throw new InternalError("Incomplete typing");
+	typing->internalError(line(), col(), "incomplete typing");
 	typing->nodeType(this, ErrorType::produce());
 	return;
 }
@@ -473,6 +502,7 @@ void BinaryExpNode::binaryEqTyping(TypeAnalysis * typing){
 	const PtrType * rhsPtr = rhsType->asPtr();
 	if (lhsPtr && rhsPtr){
 		typing->nodeType(this, BasicType::BOOL());
+		this->setExpTypes(lhsType);
 		return;
 	}
 
@@ -574,25 +604,22 @@ static const DataType * typeUnaryMath(
 void PostDecStmtNode::typeAnalysis(TypeAnalysis * typing){
 	typing->nodeType(this, typeUnaryMath(this->line(), 
 		this->col(), typing, myLVal));
-    (*this->getIntValue())--;
-    myLVal->addValueToSymbol(this->getIntValue(), nullptr, nullptr);
 }
 
 void PostIncStmtNode::typeAnalysis(TypeAnalysis * typing){
 	typing->nodeType(this, typeUnaryMath(this->line(), 
 		this->col(), typing, myLVal));
-    this->getIntValue();
-    (*this->getIntValue())++;
-    myLVal->addValueToSymbol(this->getIntValue(), nullptr, nullptr);
 }
 
 void FromConsoleStmtNode::typeAnalysis(TypeAnalysis * typing){
 	myDst->typeAnalysis(typing);
 	const DataType * childType = typing->nodeType(myDst);
 	const BasicType * childAsVar = childType->asBasic();
+	myDstType = childAsVar;
 
-	if (childType->asBasic()){
+	if (childAsVar){
 		//Always ok
+		typing->nodeType(this, BasicType::VOID());
 		return;
 	} else if (childType->asPtr()){
 		//Always bad
@@ -603,7 +630,10 @@ void FromConsoleStmtNode::typeAnalysis(TypeAnalysis * typing){
 		typing->nodeType(this, ErrorType::produce());
 		return;
 	} else {
-		throw new InternalError("unaccounted-for type");
+		typing->internalError(myDst->line(), myDst->col(),
+			"unaccounted-for type");
+		typing->nodeType(this, ErrorType::produce());
+		return;
 	}
 	typing->nodeType(this, BasicType::VOID());
 }
@@ -611,6 +641,7 @@ void FromConsoleStmtNode::typeAnalysis(TypeAnalysis * typing){
 void ToConsoleStmtNode::typeAnalysis(TypeAnalysis * typing){
 	mySrc->typeAnalysis(typing);
 	const DataType * childType = typing->nodeType(mySrc);
+	mySrcType = childType;
 
 	//Mark error, but don't re-report
 	if (childType->asError()){
@@ -627,25 +658,15 @@ void ToConsoleStmtNode::typeAnalysis(TypeAnalysis * typing){
 		typing->badWriteFn(mySrc->line(), mySrc->col());
 		typing->nodeType(this, ErrorType::produce());
 		return;
-	} else if (childType->asBasic()){
-		//Can write to a var of any other type
-    cout << "> "; 
-    if(childType->isInt()){
-      cout << (*mySrc->getIntValue()) << endl;
-    } else if(childType->isChar()){
-      cout << (*mySrc->getCharValue()) << endl;
-    } else if(childType->isBool()){
-      cout << (*mySrc->getBoolValue()) << endl;
-    } else {
-    }
-  }
+	}
+
+	//Only a charptr (a string) can be written as a pointer
   if (const PtrType * asPtr = childType->asPtr()){
 		const DataType * deref = PtrType::derefType(asPtr);
 		const BasicType * base = deref->asBasic();
 		assert(base != nullptr);
 			
 		if (base->isChar()){
-      cout << (*mySrc->getStrValue()) << endl;
 			typing->nodeType(this, BasicType::VOID());
 		} else {
 			size_t line = mySrc->line();
@@ -655,6 +676,7 @@ void ToConsoleStmtNode::typeAnalysis(TypeAnalysis * typing){
 		return;
 	}
 
+	//Can write to a var of any other type
 	typing->nodeType(this, BasicType::VOID());
 }
 
@@ -677,11 +699,7 @@ void IfStmtNode::typeAnalysis(TypeAnalysis * typing){
 			ErrorType::produce());
 	}
 
-  if(myCond->getBoolValue()){
-    for (auto stmt : *myBody){
-      stmt->typeAnalysis(typing);
-    }
-  }
+	typeBody(typing, myBody);
 
 	if (goodCond){
 		typing->nodeType(this, BasicType::produce(VOID));
@@ -702,16 +720,9 @@ void IfElseStmtNode::typeAnalysis(TypeAnalysis * typing){
 		typing->badIfCond(myCond->line(), myCond->col());
 		goodCond = false;
 	}
-  if (myCond->getBoolValue() && (*myCond->getBoolValue())){
-    for (auto stmt : *myBodyTrue){
-      stmt->typeAnalysis(typing);
-    }
-  } else {
-    for (auto stmt : *myBodyFalse){
-      stmt->typeAnalysis(typing);
-    }
-  }
-	
+	typeBody(typing, myBodyTrue);
+	typeBody(typing, myBodyFalse);
+
 	if (goodCond){
 		typing->nodeType(this, BasicType::produce(VOID));
 	} else {
@@ -729,9 +740,7 @@ void WhileStmtNode::typeAnalysis(TypeAnalysis * typing){
 		typing->badWhileCond(myCond->line(), myCond->col());
 	}
 
-	for (auto stmt : *myBody){
-		stmt->typeAnalysis(typing);
-	}
+	typeBody(typing, myBody);
 
 	typing->nodeType(this, BasicType::VOID());
 }
@@ -779,6 +788,7 @@ void ReturnStmtNode::typeAnalysis(TypeAnalysis * typing){
 		typing->nodeType(this, ErrorType::produce());
 		return;
 	}
+	myType = fnRet;
 	typing->nodeType(this, ErrorType::produce());
 	return;
 }
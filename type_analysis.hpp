@@ -1,6 +1,7 @@
 #ifndef HOLEYC_TYPE_ANALYSIS
 #define HOLEYC_TYPE_ANALYSIS
 
+#include <vector>
 #include "ast.hpp"
 #include "symbol_table.hpp"
 #include "types.hpp"
@@ -31,6 +32,15 @@ public:
   static TypeAnalysis * build(NameAnalysis * astRoot);
 	//static TypeAnalysis * build();
 
+	//Type check each of stmts (which have all passed name
+	// analysis) with up to threads threads working through them,
+	// each check in a TypeAnalysis of its own. passed[i] says
+	// whether stmts[i] passed. Errors are held back until every
+	// check is done and then reported in source order, so the
+	// output doesn't depend on how the work was split up.
+	static void checkAll(const std::vector<StmtNode *>& stmts,
+		std::vector<char>& passed, size_t threads);
+
 	//The type analysis has an instance variable to say whether
 	// the analysis failed or not. Setting this variable is much
 	// less of a pain than passing a boolean all the way up to the
@@ -39,6 +49,12 @@ public:
 		return !hasError;
 	}
 
+	//Forget earlier errors, so that passed() reports on just
+	// what is checked next (one REPL statement or function)
+	void clearError(){
+		hasError = false;
+	}
+
 	void setCurrentFnType(const FnType * type){
 		currentFnType = type;
 	}
@@ -61,10 +77,18 @@ public:
 	const DataType * nodeType(const ASTNode * node){
 		const DataType * res = nodeToType[node];
 		if (res == nullptr){
-			const char * msg = "No type for node ";
-			throw new InternalError(msg);
+			internalError(node->line(), node->col(), "no type for node");
+			return ErrorType::produce();
 		}
-		return nodeToType[node];
+		return res;
+	}
+
+	//Something the checker does not account for: a bug in the
+	// interpreter rather than the program. The statement fails
+	// type analysis like any other.
+	void internalError(size_t line, size_t col, const char * what){
+		hasError = true;
+		Report::fatal(line, col, std::string("Internal error: ") + what);
 	}
 
 	//The following functions all report and error and 
@@ -206,7 +230,8 @@ public:
 	}
 
 private:
-	HashMap<const ASTNode *, const DataType *> nodeToType;
+	TrackedMap<const ASTNode *, const DataType *, MemStats::NODE_TYPES>
+		nodeToType;
 	const FnType * currentFnType;
 	bool hasError;
 public:
@@ -6,6 +6,16 @@
 
 namespace holeyc{
 
+void * DataType::operator new(size_t size){
+	MemStats::allocated(MemStats::TYPES, size);
+	return ::operator new(size);
+}
+
+void DataType::operator delete(void * ptr, size_t size){
+	MemStats::freed(MemStats::TYPES, size);
+	::operator delete(ptr);
+}
+
 std::string BasicType::getString() const{
 	std::string res = "";
 	switch(myBaseType){
@@ -2,9 +2,11 @@
 #define XXLANG_DATA_TYPES
 
 #include <list>
+#include <mutex>
 #include <sstream>
 #include "err.hpp"
 #include "errors.hpp"
+#include "mem_stats.hpp"
 
 #include <unordered_map>
 
@@ -35,6 +37,12 @@ enum BaseType{
 // using the is<X> functions.
 class DataType{
 public:
+	virtual ~DataType(){ }
+	//Types are allocated through these so that they are counted in
+	// MemStats. Basic and pointer types are flyweights, so only
+	// function types should keep growing.
+	static void * operator new(size_t size);
+	static void operator delete(void * ptr, size_t size);
 	virtual std::string getString() const = 0;
 	virtual const BasicType * asBasic() const { return nullptr; }
 	virtual const PtrType * asPtr() const { return nullptr; }
@@ -113,15 +121,20 @@ public:
 		// multiple calls to this function (it is essentially
 		// a global variable that can only be accessed
 		// in this function).
-		static std::list<BasicType *> flyweights;
+		//Every base type is made when the list is initialized
+		// (which happens once, even if threads race to it), so
+		// type checks running in parallel only ever read it.
+		static const std::list<BasicType *> flyweights = {
+			new BasicType(BaseType::INT), new BasicType(BaseType::VOID),
+			new BasicType(BaseType::BOOL), new BasicType(BaseType::CHAR)
+		};
 		for(BasicType * fly : flyweights){
 			if (fly->getBaseType() == base){
 				return fly;
 			}
 		}
-		BasicType * newType = new BasicType(base);
-		flyweights.push_back(newType);
-		return newType;
+		//Every base type has a flyweight, so this is never reached
+		return nullptr;
 	}
 	const BasicType * asBasic() const override {
 		return this;
@@ -162,8 +175,9 @@ private:
 class PtrType : public DataType{
 public:
 	static PtrType * produce(const BasicType * basicType, int level){
+		//There is no pointer of level 0; callers never ask for one
 		if (level <= 0){
-			throw new InternalError("bad pointer level");
+			return nullptr;
 		}
 
 		//Note the use of the static local variable, which
@@ -172,6 +186,10 @@ public:
 		// a global variable that can only be accessed
 		// in this function).
 		static std::list<PtrType *> flyweights;
+		//Pointer types are made on demand, possibly by type
+		// checks running in parallel
+		static std::mutex lock;
+		std::lock_guard<std::mutex> held(lock);
 		for(PtrType * fly : flyweights){
 			if (fly->myBasicType == basicType){
 				if (fly->myLevel == level){